@@ -0,0 +1,875 @@
+#include "HeadlessWindow.hpp"
+#include "../WindowInput/EventQueue.hpp"
+#include "../WindowInput/FramePacer.hpp"
+#include "../WindowInput/Instrumentation.hpp"
+#include "../WindowInput/KeyState.hpp"
+#include "../WindowInput/LiveResize.hpp"
+#include "../WindowInput/PointerHistory.hpp"
+#include "../WindowInput/Trace.hpp"
+#include "../WindowInput/Region.hpp"
+#include "../WindowInput/Surface.hpp"
+#include "../WindowInput/WindowListeners.hpp"
+#include "../WindowInput/WindowMemory.hpp"
+#include "../WindowInput/WindowTitle.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <vector>
+
+#define HEADLESS_SCREEN_WIDTH 1920
+#define HEADLESS_SCREEN_HEIGHT 1080
+
+static PWindow root_window{ nullptr };
+
+static unsigned int pack(int low, int high) noexcept
+{
+	return static_cast<unsigned short>(low) | static_cast<unsigned int>(static_cast<unsigned short>(high)) << 16;
+}
+
+static void unpack(unsigned int value, short& low, short& high) noexcept
+{
+	low = static_cast<short>(value & 0xffff);
+	high = static_cast<short>(value >> 16);
+}
+
+/**
+ * Framebuffer Surface in memory
+ * the front buffer stands for the client area @see headlessGetPixel
+ */
+struct HeadlessSurface final : Surface
+{
+	HeadlessSurface(short width, short height)
+		: Surface(width, height)
+		, m_pixels(2 * static_cast<size_t>(width) * height)
+	{
+		m_buffers[0] = m_pixels.data();
+		m_buffers[1] = m_pixels.data() + static_cast<size_t>(width) * height;
+	}
+
+	/**
+	 * @return the pixel presented last, 0 outside the surface or before the first present
+	 */
+	unsigned int pixel(short x, short y) const noexcept
+	{
+		if (!m_presented || x < 0 || y < 0 || x >= m_width || y >= m_height) return 0;
+		return m_buffers[m_back ^ 1][y * m_pitch + x];
+	}
+
+protected:
+	void push(unsigned int buffer, Region const& damage) noexcept override
+	{
+		m_presented = true;
+	}
+
+private:
+	std::vector<unsigned int> m_pixels;
+	std::atomic<bool> m_presented{ false };
+};
+
+struct HeadlessWindow;
+
+// the top-level windows, closed by releaseRootWindow
+static std::mutex top_level_mutex;
+static std::vector<std::weak_ptr<HeadlessWindow>> top_level_windows;
+
+struct HeadlessWindow final : IWindow, std::enable_shared_from_this<HeadlessWindow>
+{
+	int const m_style;
+
+	// the low-order word specifies a width of the client area (LOWORD)
+	// the high-order word specifies a height of the client area (HIWORD)
+	mutable std::atomic<unsigned int> m_clientAreaSize;
+
+	// the low-order word specifies a X-coordinate of the cursor (LOWORD)
+	// the high-order word specifies a Y-coordinate of the cursor (HIWORD)
+	mutable std::atomic<unsigned int> m_clientAreaCursor{ 0 };
+
+	mutable std::atomic<bool> m_closed{ false };
+	mutable std::atomic<bool> m_mapped{ false };
+	mutable std::atomic<bool> m_minimized{ false };
+	mutable std::atomic<bool> m_focused{ false };
+
+	mutable WindowListeners m_listeners;
+
+	mutable EventQueue m_events;
+
+	mutable KeyState m_keys;
+
+	mutable PointerHistory m_history;
+
+	mutable std::shared_ptr<HeadlessSurface> m_surface{ nullptr };
+
+	mutable FramePacer m_pacer;
+
+	mutable WindowDamage m_damage;
+
+	mutable LiveResize m_resize;
+
+private:
+	// empty for a top-level window
+	std::weak_ptr<HeadlessWindow const> const m_parent;
+	bool const m_isTopLevel;
+
+	// keeps a window alive while it is open as the native backends do
+	mutable std::shared_ptr<HeadlessWindow> m_self{ nullptr };
+
+	mutable std::mutex m_mutex;
+	mutable std::pmr::string m_title{ windowMemory() };
+	mutable std::pmr::wstring m_unicodeTitle{ windowMemory() };
+	mutable bool m_isUnicode = false;
+	// the title in UTF-8, as the native backends cache it
+	mutable WindowTitle m_cachedTitle;
+	mutable std::vector<std::weak_ptr<HeadlessWindow>> m_children;
+
+	HeadlessWindow(int style, short width, short height, std::weak_ptr<HeadlessWindow const> parent) noexcept
+		: m_style(style)
+		, m_clientAreaSize(pack(width, height))
+		, m_parent(parent)
+		, m_isTopLevel(parent.expired())
+	{
+	}
+
+public:
+	template<typename Char>
+	static std::shared_ptr<HeadlessWindow> create(Char const* title, int style, short width, short height, HeadlessWindow const* parent)
+	{
+		std::shared_ptr<HeadlessWindow> window = allocateWindow<HeadlessWindow>([&](void* block) {
+			return new (block) HeadlessWindow(style, width, height, parent ? parent->weak_from_this() : std::weak_ptr<HeadlessWindow const>());
+		});
+		if (title)
+		{
+			window->setTitle(title);
+		}
+		window->m_self = window;
+		if (parent)
+		{
+			std::lock_guard<std::mutex> lock(parent->m_mutex);
+			parent->m_children.emplace_back(window);
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(top_level_mutex);
+			if (top_level_windows.size() == top_level_windows.capacity())
+			{
+				top_level_windows.erase(std::remove_if(top_level_windows.begin(), top_level_windows.end(),
+					[](std::weak_ptr<HeadlessWindow> const& top_level) { return top_level.expired(); }), top_level_windows.end());
+			}
+			top_level_windows.emplace_back(window);
+		}
+		return window;
+	}
+
+	static std::vector<PWindow> createMany(WindowSpec const* specs, size_t count, HeadlessWindow const* parent)
+	{
+		std::vector<PWindow> windows;
+		windows.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			WindowSpec const& spec = specs[i];
+			windows.emplace_back(spec.title != nullptr || spec.unicode == nullptr
+				? create(spec.title, spec.style, spec.width, spec.height, parent)
+				: create(spec.unicode, spec.style, spec.width, spec.height, parent));
+		}
+		return windows;
+	}
+
+	/**
+	 * list the open windows of a list, called under the lock of the list
+	 */
+	static size_t children(std::vector<std::weak_ptr<HeadlessWindow>> const& windows, PWindow* children, size_t capacity)
+	{
+		size_t count = 0;
+		for (std::weak_ptr<HeadlessWindow> const& child : windows)
+		{
+			std::shared_ptr<HeadlessWindow> window = child.lock();
+			if (window == nullptr || window->m_closed) continue;
+			if (count < capacity) children[count] = static_cast<std::shared_ptr<HeadlessWindow>&&>(window);
+			++count;
+		}
+		return count;
+	}
+
+	static std::future<PWindow> ready(PWindow window)
+	{
+		std::promise<PWindow> promise;
+		promise.set_value(static_cast<PWindow&&>(window));
+		return promise.get_future();
+	}
+
+	/**
+	 * close the window and its children, the last statement since it may release the window
+	 */
+	void detach() const noexcept
+	{
+		if (m_closed.exchange(true)) return;
+		std::vector<std::weak_ptr<HeadlessWindow>> children;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			children.swap(m_children);
+		}
+		for (std::weak_ptr<HeadlessWindow> const& child : children)
+		{
+			if (std::shared_ptr<HeadlessWindow> window = child.lock())
+			{
+				window->detach();
+			}
+		}
+		m_events.push(Event::make(WEVENT_CLOSE));
+		m_listeners.notify([this](IWindowListener& listener) { listener.onClose(*this); });
+		std::shared_ptr<HeadlessWindow> self = static_cast<std::shared_ptr<HeadlessWindow>&&>(m_self);
+	}
+
+	/**
+	 * handle an injected event as a native backend handles a native event
+	 */
+	void dispatch(Event const& event) const
+	{
+		switch (event.type)
+		{
+		case WEVENT_RESIZE:
+			if (m_clientAreaSize.exchange(pack(event.x, event.y)) == pack(event.x, event.y)) return;
+			// without a display refresh the frames pace a live resize, a change is held back until the next frame
+			if (m_resize.hold(~0ull)) return;
+			notifyResize();
+			return;
+
+		case WEVENT_LIVERESIZE:
+			if (event.code != 0)
+			{
+				if (!m_resize.begin()) return;
+			}
+			else
+			{
+				bool held;
+				if (!m_resize.end(held)) return;
+				if (held) notifyResize();
+			}
+			{
+				short width, height;
+				unpack(m_clientAreaSize, width, height);
+				m_events.push(Event{ event.type, event.code, width, height, event.time });
+			}
+			m_listeners.notify([this, &event](IWindowListener& listener) { listener.onLiveResize(*this, event.code != 0); });
+			return;
+
+		case WEVENT_FOCUS:
+			if (event.code == 0) m_keys.clear();
+			if (m_focused.exchange(event.code != 0) == (event.code != 0)) return;
+			m_events.push(event);
+			m_listeners.notify([this, &event](IWindowListener& listener) { listener.onFocus(*this, event.code != 0); });
+			return;
+
+		case WEVENT_MOTION:
+			m_clientAreaCursor = pack(event.x, event.y);
+			m_history.record(event.x, event.y, event.time);
+			m_events.push(event);
+			m_listeners.notify([this, &event](IWindowListener& listener) { listener.onPointerMove(*this, event.x, event.y); });
+			return;
+
+		case WEVENT_KEYDOWN:
+		case WEVENT_KEYUP:
+			m_keys.set(static_cast<unsigned char>(event.code), event.type == WEVENT_KEYDOWN);
+			m_events.push(event);
+			m_listeners.notify([this, &event](IWindowListener& listener) { listener.onKey(*this, event.code, event.type == WEVENT_KEYDOWN); });
+			return;
+
+		case WEVENT_TEXT:
+			m_events.push(event);
+			m_listeners.notify([this, &event](IWindowListener& listener) { listener.onText(*this, event.codepoint()); });
+			return;
+
+		case WEVENT_CLOSE:
+			detach();
+			return;
+
+		default:
+			m_events.push(event);
+			return;
+		}
+	}
+
+	PWindow create(char const* title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return create(title, style, width, height, this);
+	}
+
+	PWindow create(wchar_t const* title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return create(title, style, width, height, this);
+	}
+
+	PWindow create(int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return create(static_cast<char const*>(nullptr), style, width, height, this);
+	}
+
+	std::future<PWindow> createAsync(std::string title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return ready(create(title.c_str(), style, width, height, this));
+	}
+
+	std::future<PWindow> createAsync(std::wstring title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return ready(create(title.c_str(), style, width, height, this));
+	}
+
+	std::future<PWindow> createAsync(int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return ready(create(style, width, height));
+	}
+
+	std::vector<PWindow> createMany(WindowSpec const* specs, size_t count) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEMANY);
+		return createMany(specs, count, this);
+	}
+
+	void show() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_SHOW);
+		m_minimized = false;
+		// mapping a window exposes its whole client area
+		if (!m_mapped.exchange(true))
+		{
+			short width, height;
+			unpack(m_clientAreaSize, width, height);
+			m_damage.add(0, 0, width, height);
+		}
+	}
+
+	void minimize() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_MINIMIZE);
+		m_minimized = true;
+	}
+
+	void hide() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_HIDE);
+		m_mapped = false;
+	}
+
+	void close() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_CLOSE);
+		detach();
+	}
+
+	bool isClosed() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_ISCLOSED);
+		return m_closed;
+	}
+
+	bool isVisible() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_ISVISIBLE);
+		return m_mapped && !m_minimized;
+	}
+
+	bool isHidden() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_ISHIDDEN);
+		return !m_mapped || m_minimized;
+	}
+
+	bool isActive() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_ISACTIVE);
+		return m_focused;
+	}
+
+	void getClientSize(short& width, short& height) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETCLIENTSIZE);
+		unpack(m_clientAreaSize, width, height);
+	}
+
+	void getClientCursorPos(short& x, short& y) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETCLIENTCURSORPOS);
+		unpack(m_clientAreaCursor, x, y);
+	}
+
+	Title getTitle() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETTITLE);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_isUnicode) return std::wstring(m_unicodeTitle.data(), m_unicodeTitle.size());
+		return std::string(m_title.data(), m_title.size());
+	}
+
+	void setTitle(char const* title) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_SETTITLE);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_title = title ? title : "";
+		m_isUnicode = false;
+		m_cachedTitle.store(m_title.data(), m_title.size());
+	}
+
+	void setTitle(wchar_t const* title) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_SETTITLE);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_unicodeTitle = title ? title : L"";
+		m_isUnicode = true;
+		m_cachedTitle.store(title);
+	}
+
+	size_t getTitle(char* buffer, size_t capacity) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETTITLE);
+		return m_cachedTitle.copy(buffer, capacity);
+	}
+
+	PWindow getParent() const override
+	{
+		WINSTRUMENT_CALL(WCALL_GETPARENT);
+		return m_isTopLevel ? root_window : PWindow(m_parent.lock());
+	}
+
+	size_t getChildren(PWindow* children, size_t capacity) const override
+	{
+		WINSTRUMENT_CALL(WCALL_GETCHILDREN);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return HeadlessWindow::children(m_children, children, capacity);
+	}
+
+	size_t getPointerHistory(PointerSample* samples, size_t capacity) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETPOINTERHISTORY);
+		return m_history.read(samples, capacity);
+	}
+
+	size_t takeDamage(WindowRect* rects, size_t capacity) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_TAKEDAMAGE);
+		return m_damage.take(rects, capacity);
+	}
+
+	void requestFrames(bool enabled) const override
+	{
+		WINSTRUMENT_CALL(WCALL_REQUESTFRAMES);
+		m_pacer.request(enabled);
+	}
+
+	FrameStats getFrameStats() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETFRAMESTATS);
+		return m_pacer.stats();
+	}
+
+	/**
+	 * deliver a frame as the scheduler of a native backend does
+	 */
+	void notifyResize() const
+	{
+		short width, height;
+		unpack(m_clientAreaSize, width, height);
+		m_events.push(Event::make(WEVENT_RESIZE, 0, width, height));
+		m_listeners.notify([this, width, height](IWindowListener& listener) { listener.onResize(*this, width, height); });
+	}
+
+	void frame() const
+	{
+		if (m_resize.release())
+		{
+			notifyResize();
+		}
+		if (!m_pacer.claim()) return;
+		FrameStats stats;
+		if (m_pacer.frame(m_mapped && !m_minimized, stats))
+		{
+			m_listeners.notify([this, &stats](IWindowListener& listener) { listener.onFrame(*this, stats); });
+		}
+	}
+
+	PSurface createSurface(short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATESURFACE);
+		if (m_closed || width <= 0 || height <= 0) return nullptr;
+		std::shared_ptr<HeadlessSurface> surface = std::make_shared<HeadlessSurface>(width, height);
+		std::atomic_store(&m_surface, surface);
+		return surface;
+	}
+
+	bool isKeyDown(unsigned char key) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_ISKEYDOWN);
+		return m_keys.test(key);
+	}
+
+	bool isLiveResizing() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_ISLIVERESIZING);
+		return m_resize.live();
+	}
+
+	size_t drainEvents(Event* events, size_t capacity) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_DRAINEVENTS);
+		return m_events.drain(events, capacity);
+	}
+
+	/**
+	 * @see recordEvents
+	 */
+	bool record(FILE* file) const noexcept
+	{
+		return m_events.record(file);
+	}
+
+	// the injected events leave no requests to send
+	void flush() const noexcept override { WINSTRUMENT_CALL(WCALL_FLUSH); }
+
+	void openBatch() const noexcept override { WINSTRUMENT_CALL(WCALL_OPENBATCH); }
+
+	void endBatch() const noexcept override { WINSTRUMENT_CALL(WCALL_ENDBATCH); }
+
+	void subscribe(PWindowListener listener) const override
+	{
+		WINSTRUMENT_CALL(WCALL_SUBSCRIBE);
+		m_listeners.add(static_cast<PWindowListener&&>(listener));
+	}
+
+	void unsubscribe(PWindowListener const& listener) const override
+	{
+		WINSTRUMENT_CALL(WCALL_UNSUBSCRIBE);
+		m_listeners.remove(listener);
+	}
+};
+
+struct HeadlessRootWindow final : IWindow
+{
+	PWindow create(char const* title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return HeadlessWindow::create(title, style, width, height, nullptr);
+	}
+
+	PWindow create(wchar_t const* title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return HeadlessWindow::create(title, style, width, height, nullptr);
+	}
+
+	PWindow create(int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return HeadlessWindow::create(static_cast<char const*>(nullptr), style, width, height, nullptr);
+	}
+
+	std::future<PWindow> createAsync(std::string title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return HeadlessWindow::ready(create(title.c_str(), style, width, height));
+	}
+
+	std::future<PWindow> createAsync(std::wstring title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return HeadlessWindow::ready(create(title.c_str(), style, width, height));
+	}
+
+	std::future<PWindow> createAsync(int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return HeadlessWindow::ready(create(style, width, height));
+	}
+
+	std::vector<PWindow> createMany(WindowSpec const* specs, size_t count) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEMANY);
+		return HeadlessWindow::createMany(specs, count, nullptr);
+	}
+
+	void show() const noexcept override {}
+
+	void minimize() const noexcept override {}
+
+	void hide() const noexcept override {}
+
+	void close() const noexcept override {}
+
+	bool isClosed() const noexcept override { return false; }
+
+	bool isVisible() const noexcept override { return false; }
+
+	bool isHidden() const noexcept override { return false; }
+
+	bool isActive() const noexcept override { return false; }
+
+	void getClientSize(short& width, short& height) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETCLIENTSIZE);
+		width = HEADLESS_SCREEN_WIDTH;
+		height = HEADLESS_SCREEN_HEIGHT;
+	}
+
+	void getClientCursorPos(short& x, short& y) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETCLIENTCURSORPOS);
+		unpack(m_cursor, x, y);
+	}
+
+	Title getTitle() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETTITLE);
+		return {};
+	}
+
+	size_t getTitle(char* buffer, size_t capacity) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETTITLE);
+		if (capacity) *buffer = '\0';
+		return 0;
+	}
+
+	void setTitle(char const* title) const noexcept override {}
+
+	void setTitle(wchar_t const* title) const noexcept override {}
+
+	PWindow getParent() const override { return root_window; }
+
+	size_t getChildren(PWindow* children, size_t capacity) const override
+	{
+		WINSTRUMENT_CALL(WCALL_GETCHILDREN);
+		std::lock_guard<std::mutex> lock(top_level_mutex);
+		return HeadlessWindow::children(top_level_windows, children, capacity);
+	}
+
+	size_t getPointerHistory(PointerSample* samples, size_t capacity) const noexcept override { return 0; }
+
+	size_t takeDamage(WindowRect* rects, size_t capacity) const noexcept override { return 0; }
+
+	void requestFrames(bool enabled) const override {}
+
+	FrameStats getFrameStats() const noexcept override { return FrameStats{}; }
+
+	PSurface createSurface(short width, short height) const override { return nullptr; }
+
+	bool isKeyDown(unsigned char key) const noexcept override { return false; }
+
+	bool isLiveResizing() const noexcept override { return false; }
+
+	size_t drainEvents(Event* events, size_t capacity) const noexcept override { return 0; }
+
+	void flush() const noexcept override {}
+
+	void openBatch() const noexcept override {}
+
+	void endBatch() const noexcept override {}
+
+	void subscribe(PWindowListener listener) const override {}
+
+	void unsubscribe(PWindowListener const& listener) const override {}
+
+	// the synthetic cursor position on the screen, @see headlessPointerMove
+	mutable std::atomic<unsigned int> m_cursor{ 0 };
+
+	// the window having the focus
+	mutable std::mutex m_mutex;
+	mutable std::weak_ptr<HeadlessWindow> m_focus;
+};
+
+EXTERN_C Window getRootWindow()
+{
+	if (root_window == nullptr)
+	{
+		root_window = std::make_shared<HeadlessRootWindow>();
+	}
+	return *root_window;
+}
+
+PWindow getRootWindow(char const* display, int screen)
+{
+	// the in-memory screen is the only display
+	if (display != nullptr && *display != '\0') return nullptr;
+	getRootWindow();
+	return root_window;
+}
+
+static HeadlessWindow const* headless(Window window) noexcept
+{
+	HeadlessWindow const* p_window = dynamic_cast<HeadlessWindow const*>(&window);
+	return p_window && !p_window->isClosed() ? p_window : nullptr;
+}
+
+void headlessResize(Window window, short width, short height)
+{
+	headlessInject(window, Event::make(WEVENT_RESIZE, 0, width, height));
+}
+
+void headlessLiveResize(Window window, bool active)
+{
+	headlessInject(window, Event::make(WEVENT_LIVERESIZE, active, 0, 0));
+}
+
+void headlessFocus(Window window, bool active)
+{
+	headlessInject(window, Event::make(WEVENT_FOCUS, active, 0, 0));
+}
+
+void headlessPointerMove(Window window, short x, short y)
+{
+	headlessInject(window, Event::make(WEVENT_MOTION, 0, x, y));
+}
+
+void headlessClose(Window window)
+{
+	headlessInject(window, Event::make(WEVENT_CLOSE));
+}
+
+void headlessInject(Window window, Event const& event)
+{
+	if (HeadlessRootWindow const* p_root = dynamic_cast<HeadlessRootWindow const*>(&window))
+	{
+		if (event.type == WEVENT_MOTION)
+		{
+			p_root->m_cursor = pack(event.x, event.y);
+		}
+		return;
+	}
+	HeadlessWindow const* p_window = headless(window);
+	if (p_window == nullptr) return;
+	if (event.type == WEVENT_FOCUS)
+	{
+		// a window getting the focus takes it from the window having it
+		HeadlessRootWindow const& root = static_cast<HeadlessRootWindow const&>(getRootWindow());
+		std::shared_ptr<HeadlessWindow> previous{ nullptr };
+		{
+			std::lock_guard<std::mutex> lock(root.m_mutex);
+			previous = root.m_focus.lock();
+			if (event.code)
+			{
+				root.m_focus = std::const_pointer_cast<HeadlessWindow>(p_window->shared_from_this());
+			}
+			else if (previous.get() == p_window)
+			{
+				root.m_focus.reset();
+			}
+		}
+		if (event.code && previous && previous.get() != p_window)
+		{
+			previous->dispatch(Event{ WEVENT_FOCUS, 0, 0, 0, event.time });
+		}
+	}
+	p_window->dispatch(event);
+}
+
+EXTERN_C void setEventThreads(unsigned int threads)
+{
+	// the events are dispatched by the threads injecting them
+}
+
+EXTERN_C void setFrameRate(unsigned int hz)
+{
+	// the frames are ticked by headlessFrame
+}
+
+EXTERN_C void setAutoFlush(bool enabled)
+{
+	// the injected events leave no requests to send
+}
+
+EXTERN_C void setHibernation(unsigned int ms)
+{
+	// the windows hold no resources of a display
+}
+
+void setWindowMemory(std::pmr::memory_resource* resource)
+{
+	windowMemoryResource() = resource ? resource : defaultWindowMemory();
+}
+
+bool getInstrumentation(InstrumentationSnapshot& snapshot) noexcept
+{
+	return Instrumentation::take(snapshot);
+}
+
+void dumpInstrumentation(FILE* file, bool json) noexcept
+{
+	Instrumentation::dump(file, json);
+}
+
+void setInstrumentationDump(FILE* file, unsigned int interval, bool json)
+{
+	Instrumentation::schedule(file, interval, json);
+}
+
+void setTracing(bool enabled) noexcept
+{
+	Trace::get().enable(enabled);
+}
+
+bool exportTrace(FILE* file)
+{
+	return Trace::get().write(file);
+}
+
+bool recordEvents(Window window, FILE* file)
+{
+	HeadlessWindow const* p_window = headless(window);
+	return p_window ? p_window->record(file) : false;
+}
+
+size_t replayEvents(Window window, FILE* file, double speed)
+{
+	// every recorded event goes back through headlessInject, the injected events are the native events here
+	return replayEventFile(file, speed, [&window](Event const& event) { headlessInject(window, event); });
+}
+
+EXTERN_C void releaseRootWindow()
+{
+	std::vector<std::weak_ptr<HeadlessWindow>> windows;
+	{
+		std::lock_guard<std::mutex> lock(top_level_mutex);
+		windows.swap(top_level_windows);
+	}
+	for (std::weak_ptr<HeadlessWindow> const& window : windows)
+	{
+		if (std::shared_ptr<HeadlessWindow> p_window = window.lock())
+		{
+			p_window->detach();
+		}
+	}
+	root_window = nullptr;
+}
+
+void headlessFrame(Window window)
+{
+	if (HeadlessWindow const* p_window = dynamic_cast<HeadlessWindow const*>(&window))
+	{
+		p_window->frame();
+	}
+}
+
+void headlessExpose(Window window, short x, short y, short width, short height)
+{
+	if (HeadlessWindow const* p_window = dynamic_cast<HeadlessWindow const*>(&window))
+	{
+		p_window->m_damage.add(x, y, width, height);
+	}
+}
+
+unsigned int headlessGetPixel(Window window, short x, short y)
+{
+	HeadlessWindow const* p_window = dynamic_cast<HeadlessWindow const*>(&window);
+	std::shared_ptr<HeadlessSurface> surface = p_window ? std::atomic_load(&p_window->m_surface) : nullptr;
+	return surface ? surface->pixel(x, y) : 0;
+}
+
+int headlessGetStyle(Window window)
+{
+	HeadlessWindow const* p_window = dynamic_cast<HeadlessWindow const*>(&window);
+	return p_window ? p_window->m_style : WSTYLE_DEFAULT;
+}
@@ -0,0 +1,77 @@
+#ifndef __HEADLESSWINDOW_HPP
+#define __HEADLESSWINDOW_HPP 1
+
+#include "../WindowInput/Window.hpp"
+
+/**
+ * Headless Event Injection
+ * an injected event is dispatched on the calling thread as a native backend dispatches a native event,
+ * the windows not created by the headless backend ignore it
+ */
+
+/**
+ * @param window[in] the window to resize
+ * @param width[in] the new width of the client area
+ * @param height[in] the new height of the client area
+ */
+void headlessResize(Window window, short width, short height);
+
+/**
+ * begin or end dragging the frame of a window, meanwhile a resize is held back until the next frame
+ * @param window[in] the window being resized
+ * @param active[in] whether the live resize begins or ends
+ */
+void headlessLiveResize(Window window, bool active);
+
+/**
+ * @param window[in] the window gaining or losing the focus, the other windows lose it
+ * @param active[in] whether the window gets the focus
+ */
+void headlessFocus(Window window, bool active);
+
+/**
+ * @param window[in] the window under the pointer
+ * @param x[in] the x-coordinate of the client area cursor position
+ * @param y[in] the y-coordinate of the client area cursor position
+ */
+void headlessPointerMove(Window window, short x, short y);
+
+/**
+ * close a window as if the user closed it
+ * @param window[in] the window to close
+ */
+void headlessClose(Window window);
+
+/**
+ * inject any normalized event, the button and wheel events only reach the event queue
+ * @param window[in] the window receiving the event
+ * @param event[in] the event @see WEVENT_*
+ */
+void headlessInject(Window window, Event const& event);
+
+/**
+ * expose a part of the client area as if a window covering it went away
+ * @param window[in] the exposed window
+ */
+void headlessExpose(Window window, short x, short y, short width, short height);
+
+/**
+ * tick the display refresh for a window requesting frames, on the calling thread,
+ * a resize held back by a live resize is delivered first
+ * @param window[in] the window to deliver a frame to, if it is mapped and not minimized
+ */
+void headlessFrame(Window window);
+
+/**
+ * @param window[in] a window of the headless backend
+ * @return the 0x00RRGGBB pixel of the client area the surface of the window presented last, 0 without one
+ */
+unsigned int headlessGetPixel(Window window, short x, short y);
+
+/**
+ * @param window[in] a window of the headless backend
+ * @return the style the window was created with @see WSTYLE_DEFAULT, WSTYLE_*
+ */
+int headlessGetStyle(Window window);
+
+#endif // !__HEADLESSWINDOW_HPP
@@ -0,0 +1,211 @@
+#include "Project3.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+#include "WindowInput/Window.hpp"
+#ifdef WINDOWINPUT_HEADLESS
+#include "HeadlessWindowInput/HeadlessWindow.hpp"
+#endif
+#ifdef __linux__
+#include <dirent.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * print the statistics of the samples as a JSON line
+ * @param name[in] the name of the measurement
+ * @param samples[in] the durations of the calls in nanoseconds
+ */
+static void report(char const* name, std::vector<double>& samples)
+{
+	if (samples.empty())
+	{
+		std::printf("{\"name\":\"%s\",\"iterations\":0}\n", name);
+		return;
+	}
+	std::sort(samples.begin(), samples.end());
+	double sum = 0;
+	for (double sample : samples) sum += sample;
+	std::printf("{\"name\":\"%s\",\"iterations\":%zu,\"mean_ns\":%.1f,\"min_ns\":%.1f,\"p50_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.1f}\n",
+		name, samples.size(), sum / samples.size(), samples.front(),
+		samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples.back());
+	std::fflush(stdout);
+}
+
+/**
+ * @param iterations[in] the number of calls
+ * @param function[in] the call to measure
+ * @return the durations of the calls in nanoseconds
+ */
+template<typename Function>
+static std::vector<double> measure(size_t iterations, Function&& function)
+{
+	std::vector<double> samples;
+	samples.reserve(iterations);
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		Clock::time_point start = Clock::now();
+		function(i);
+		samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+	}
+	return samples;
+}
+
+/**
+ * @return the number of threads of the process, -1 if unknown
+ */
+static int threadCount()
+{
+#ifdef __linux__
+	int count = 0;
+	if (DIR* dir = opendir("/proc/self/task"))
+	{
+		while (dirent* entry = readdir(dir))
+		{
+			if (entry->d_name[0] != '.') ++count;
+		}
+		closedir(dir);
+		return count;
+	}
+#endif
+	return -1;
+}
+
+/**
+ * print why the benchmark cannot run as a JSON line
+ * @return the exit code of the benchmark
+ */
+static int fail(char const* message)
+{
+	std::printf("{\"name\":\"error\",\"message\":\"%s\"}\n", message);
+	std::fflush(stdout);
+	return 1;
+}
+
+#ifdef WINDOWINPUT_HEADLESS
+struct LatencyListener final : IWindowListener
+{
+	Clock::time_point sent;
+	std::vector<double> samples;
+
+	void onPointerMove(Window, short, short) override
+	{
+		samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - sent).count());
+	}
+};
+#endif
+
+/**
+ * Project3Bench [iterations] [idle windows]
+ * prints one JSON object per line for each measurement
+ */
+int main(int argc, char* argv[])
+{
+	size_t const iterations = argc > 1 ? std::stoul(argv[1]) : 1000;
+	size_t const idleWindows = argc > 2 ? std::stoul(argv[2]) : 100;
+	if (iterations == 0) return fail("the iterations must be at least 1");
+
+	Window root = getRootWindow();
+	std::vector<PWindow> windows;
+	windows.reserve(iterations);
+
+	{
+		std::vector<double> samples = measure(iterations, [&](size_t) { windows.push_back(root.create("bench", WSTYLE_DEFAULT, 320, 240)); });
+		report("create", samples);
+	}
+	if (std::find(windows.begin(), windows.end(), nullptr) != windows.end())
+	{
+		for (PWindow const& window : windows) if (window) window->close();
+		return fail("the windows could not be created");
+	}
+	{
+		std::vector<double> samples = measure(iterations / 10 + 1, [&](size_t) { root.createAsync("bench", WSTYLE_DEFAULT, 320, 240).get()->close(); });
+		report("createAsync", samples);
+	}
+	{
+		std::vector<WindowSpec> specs(100, WindowSpec{ "panel", nullptr, WSTYLE_POPUP, 64, 64 });
+		PWindow parent = root.create("grid");
+		std::vector<double> samples = measure(iterations / 100 + 1, [&](size_t) {
+			for (PWindow const& window : parent->createMany(specs)) window->close();
+		});
+		for (double& sample : samples) sample /= specs.size();
+		report("createMany.perWindow", samples);
+		parent->close();
+	}
+
+	PWindow window = windows.front();
+	{
+		std::vector<double> samples = measure(windows.size(), [&](size_t i) { windows[i]->show(); });
+		report("show", samples);
+	}
+	{
+		short width, height;
+		std::vector<double> samples = measure(iterations, [&](size_t) { window->getClientSize(width, height); });
+		report("getClientSize", samples);
+	}
+	{
+		std::vector<double> samples = measure(iterations, [&](size_t) { window->isVisible(); });
+		report("isVisible", samples);
+	}
+	{
+		std::vector<double> samples = measure(iterations, [&](size_t) { window->getTitle(); });
+		report("getTitle", samples);
+	}
+	{
+		std::vector<double> samples = measure(iterations, [&](size_t) { window->getParent(); });
+		report("getParent", samples);
+	}
+	{
+		std::vector<std::string> titles;
+		for (size_t i = 0; i < iterations; ++i) titles.push_back("title " + std::to_string(i));
+		std::vector<double> samples = measure(iterations, [&](size_t i) { windows[i]->setTitle(titles[i]); });
+		report("setTitle", samples);
+	}
+
+#ifdef WINDOWINPUT_HEADLESS
+	{
+		std::shared_ptr<LatencyListener> listener = std::make_shared<LatencyListener>();
+		listener->samples.reserve(iterations);
+		window->subscribe(listener);
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			listener->sent = Clock::now();
+			headlessPointerMove(*window, static_cast<short>(i & 0xff), static_cast<short>(i >> 8));
+		}
+		window->unsubscribe(listener);
+		report("eventDelivery", listener->samples);
+	}
+#else
+	std::printf("{\"name\":\"eventDelivery\",\"skipped\":\"no event injection in this backend\"}\n");
+#endif
+
+	{
+		std::vector<double> samples = measure(windows.size(), [&](size_t i) { windows[i]->close(); });
+		report("close", samples);
+		windows.clear();
+	}
+
+	{
+		int const threadsBefore = threadCount();
+		for (size_t i = 0; i < idleWindows; ++i) windows.push_back(root.create("idle"));
+		for (PWindow const& idle : windows) idle->show();
+		int const threadsAfter = threadCount();
+
+		std::clock_t const cpuStart = std::clock();
+		Clock::time_point const wallStart = Clock::now();
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+		double const cpu = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+		double const wall = std::chrono::duration<double>(Clock::now() - wallStart).count();
+
+		std::printf("{\"name\":\"idle\",\"windows\":%zu,\"threads_before\":%d,\"threads_after\":%d,\"cpu_s\":%.6f,\"wall_s\":%.6f}\n",
+			idleWindows, threadsBefore, threadsAfter, cpu, wall);
+		for (PWindow const& idle : windows) idle->close();
+	}
+
+	return 0;
+}
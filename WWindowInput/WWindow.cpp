@@ -1,8 +1,27 @@
 #define WIN32_LEAN_MEAN 1
 #include <windows.h>
+#include <dwmapi.h>
 
 #include "../WindowInput/Window.hpp"
+#include "../WindowInput/EventQueue.hpp"
+#include "../WindowInput/FramePacer.hpp"
+#include "../WindowInput/Instrumentation.hpp"
+#include "../WindowInput/KeyState.hpp"
+#include "../WindowInput/LiveResize.hpp"
+#include "../WindowInput/PointerHistory.hpp"
+#include "../WindowInput/Trace.hpp"
+#include "../WindowInput/Region.hpp"
+#include "../WindowInput/Surface.hpp"
+#include "../WindowInput/WindowListeners.hpp"
+#include "../WindowInput/WindowMemory.hpp"
+#include "../WindowInput/WindowTitle.hpp"
+#include "../WindowInput/WindowTree.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
 #include <thread>
+#include <vector>
 
 // Register the window class
 bool registerWndClass(WNDCLASSEXA& wcex, HINSTANCE hInstance, char const* className, WNDPROC windowProc = DefWindowProcA)
@@ -40,7 +59,6 @@ bool registerWndClass(WNDCLASSEXW& wcex, HINSTANCE hInstance, wchar_t const* cla
 	return RegisterClassExW(&wcex) != 0;
 }
 
-static LRESULT WINAPI WindowProcA(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam);
 static LRESULT WINAPI WindowProcW(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam);
 
 EXTERN_C HWND wCreateWindowA(
@@ -116,10 +134,11 @@ EXTERN_C HWND wCreateWindowA(
 			EnableMenuItem(hMenu, SC_CLOSE, MF_BYCOMMAND | MF_GRAYED);
 		}
 	}
-	SetWindowLongPtrA(hWnd, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(WindowProcA));
+	// the wide window procedure makes the window Unicode, so its WM_CHAR carries UTF-16 instead of a byte of the ANSI code page
+	SetWindowLongPtrW(hWnd, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(WindowProcW));
 	if (pData)
 	{
-		SetWindowLongPtrA(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(pData));
+		SetWindowLongPtrW(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(pData));
 	}
 	return hWnd;
 }
@@ -222,10 +241,282 @@ EXTERN_C HWND wCreateWindow(
 
 static PWindow root_window{ nullptr };
 
+static std::atomic<unsigned int> event_threads{ 1 };
+
+static std::atomic<unsigned int> frame_rate{ 60 };
+
+// a thread message carrying a std::function<void()>* to run on an event thread
+#define WM_EVENTTHREADTASK (WM_APP + 1)
+
+// a message telling a window the time to render a frame
+#define WM_EVENTTHREADFRAME (WM_APP + 2)
+
+// the timer delivering the resizes a live resize has held back
+#define IDT_LIVERESIZE 1
+
+/**
+ * Frame Scheduler
+ * ticks at every composition of the desktop window manager, or every frame interval without one,
+ * and posts a frame to the windows requesting them
+ */
+struct WFrameScheduler final
+{
+	// the frame interval in milliseconds without a compositor
+	DWORD const m_interval;
+
+	/**
+	 * @param rate[in] the frames per second without a compositor
+	 */
+	explicit WFrameScheduler(unsigned int rate)
+		: m_interval(1000 / (rate ? rate : 60))
+	{
+		m_thread = std::thread(&WFrameScheduler::loop, this);
+	}
+
+	~WFrameScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_running = false;
+		}
+		m_condition.notify_one();
+		if (m_thread.joinable()) m_thread.join();
+	}
+
+	/**
+	 * called by the thread of the window, before it destroys the window
+	 */
+	void add(HWND hWnd, FramePacer* pacer)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_windows.emplace_back(hWnd, pacer);
+		}
+		m_condition.notify_one();
+	}
+
+	void remove(HWND hWnd) noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < m_windows.size(); ++i)
+		{
+			if (m_windows[i].first == hWnd)
+			{
+				m_windows[i] = m_windows.back();
+				m_windows.pop_back();
+				return;
+			}
+		}
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::vector<std::pair<HWND, FramePacer*>> m_windows;
+	bool m_running = true;
+	std::thread m_thread;
+
+	void loop()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true)
+		{
+			m_condition.wait(lock, [this]() { return !m_running || !m_windows.empty(); });
+			if (!m_running) break;
+			lock.unlock();
+			// DwmFlush returns at the next composition and fails without a compositor
+			if (FAILED(DwmFlush()))
+			{
+				Sleep(m_interval);
+			}
+			lock.lock();
+			for (std::pair<HWND, FramePacer*> const& window : m_windows)
+			{
+				if (window.second->claim())
+				{
+					PostMessageW(window.first, WM_EVENTTHREADFRAME, 0, 0);
+				}
+			}
+		}
+	}
+};
+
+static BOOL CALLBACK destroyThreadWindow(HWND hWnd, LPARAM)
+{
+	DestroyWindow(hWnd);
+	return TRUE;
+}
+
+/**
+ * Event Thread
+ * creates windows and pumps the messages of all of them
+ */
+struct WEventThread final
+{
+	DWORD m_threadId = 0;
+	WFrameScheduler& m_scheduler;
+	WindowTree& m_tree;
+	std::thread m_thread;
+
+	WEventThread(WFrameScheduler& scheduler, WindowTree& tree)
+		: m_scheduler(scheduler)
+		, m_tree(tree)
+	{
+		std::promise<DWORD> started;
+		std::future<DWORD> threadId = started.get_future();
+		m_thread = std::thread([this, &started]() {
+			MSG msg;
+			// create the message queue of the thread before a task is posted
+			PeekMessageA(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+			started.set_value(GetCurrentThreadId());
+			loop();
+		});
+		m_threadId = threadId.get();
+	}
+
+	/**
+	 * destroy the windows of the thread and join it
+	 */
+	~WEventThread()
+	{
+		post([this]() {
+			EnumThreadWindows(m_threadId, destroyThreadWindow, 0);
+			PostQuitMessage(0);
+		});
+		if (m_thread.joinable()) m_thread.join();
+	}
+
+	/**
+	 * run a task on the thread, right away if called by the thread
+	 */
+	void invoke(std::function<void()> task)
+	{
+		if (GetCurrentThreadId() == m_threadId)
+		{
+			task();
+			return;
+		}
+		post(static_cast<std::function<void()>&&>(task));
+	}
+
+private:
+	void post(std::function<void()> task)
+	{
+		std::function<void()>* p_task = new std::function<void()>(static_cast<std::function<void()>&&>(task));
+		if (PostThreadMessageA(m_threadId, WM_EVENTTHREADTASK, 0, reinterpret_cast<LPARAM>(p_task)) == 0)
+		{
+			delete p_task;
+		}
+	}
+
+	void loop()
+	{
+		MSG msg{};
+		Trace::name("Win32 event thread");
+		// the wide calls keep WM_CHAR in UTF-16, every window procedure is WindowProcW
+		while (GetMessageW(&msg, nullptr, 0, 0) > 0)
+		{
+			WINSTRUMENT_COUNT(WCOUNTER_WAKEUPS);
+			WTRACE_INSTANT("pickup", msg.message);
+			if (msg.hwnd == nullptr && msg.message == WM_EVENTTHREADTASK)
+			{
+				std::unique_ptr<std::function<void()>> task(reinterpret_cast<std::function<void()>*>(msg.lParam));
+				(*task)();
+				continue;
+			}
+			TranslateMessage(&msg);
+			DispatchMessageW(&msg);
+		}
+	}
+};
+
+/**
+ * Framebuffer Surface of a Window
+ * two top-down 32-bit DIB sections blitted into the client area
+ */
+struct WSurface final : Surface
+{
+	WSurface(HWND hWnd, short width, short height) noexcept
+		: Surface(width, height)
+		, m_handle(hWnd)
+	{
+		BITMAPINFO info{};
+		info.bmiHeader.biSize = sizeof info.bmiHeader;
+		info.bmiHeader.biWidth = width;
+		info.bmiHeader.biHeight = -height;
+		info.bmiHeader.biPlanes = 1;
+		info.bmiHeader.biBitCount = 32;
+		info.bmiHeader.biCompression = BI_RGB;
+		HDC hdc = GetDC(hWnd);
+		if (hdc == nullptr) return;
+		m_dc = CreateCompatibleDC(hdc);
+		for (unsigned int i = 0; i < 2; ++i)
+		{
+			void* bits = nullptr;
+			m_bitmaps[i] = CreateDIBSection(hdc, &info, DIB_RGB_COLORS, &bits, nullptr, 0);
+			m_buffers[i] = static_cast<unsigned int*>(bits);
+		}
+		ReleaseDC(hWnd, hdc);
+		if (m_dc == nullptr || m_buffers[0] == nullptr || m_buffers[1] == nullptr)
+		{
+			m_buffers[0] = m_buffers[1] = nullptr;
+		}
+	}
+
+	~WSurface() noexcept override
+	{
+		if (m_dc) DeleteDC(m_dc);
+		for (HBITMAP bitmap : m_bitmaps)
+		{
+			if (bitmap) DeleteObject(bitmap);
+		}
+	}
+
+	bool valid() const noexcept
+	{
+		return m_buffers[0] != nullptr;
+	}
+
+protected:
+	void push(unsigned int buffer, Region const& damage) noexcept override
+	{
+		HDC hdc = GetDC(m_handle);
+		if (hdc == nullptr) return;
+		HGDIOBJ previous = SelectObject(m_dc, m_bitmaps[buffer]);
+		for (WindowRect const& rect : damage)
+		{
+			BitBlt(hdc, rect.x, rect.y, rect.width, rect.height, m_dc, rect.x, rect.y, SRCCOPY);
+		}
+		SelectObject(m_dc, previous);
+		ReleaseDC(m_handle, hdc);
+		// the batched GDI calls must not read a section the caller is drawing into
+		GdiFlush();
+	}
+
+private:
+	HWND const m_handle;
+	HDC m_dc = nullptr;
+	HBITMAP m_bitmaps[2]{ nullptr, nullptr };
+};
+
+/**
+ * cache a title in the ANSI code page in UTF-8
+ */
+static void wStoreTitle(WindowTitle& title, char const* ansi)
+{
+	int const length = MultiByteToWideChar(CP_ACP, 0, ansi ? ansi : "", -1, nullptr, 0);
+	std::wstring wide(length > 0 ? length : 1, L'\0');
+	MultiByteToWideChar(CP_ACP, 0, ansi ? ansi : "", -1, &wide[0], length);
+	title.store(wide.c_str());
+}
+
 struct WWindow final : IWindow
 {
 	HWND const m_handle = nullptr;
 
+	// the thread creating the window and its children, and pumping their messages
+	WEventThread& m_thread;
+
 	// the low-order word specifies a width of the client area (LOWORD) 
 	// the high-order word specifies a height of the client area (HIWORD) 
 	unsigned int m_clientAreaSize;
@@ -234,35 +525,72 @@ struct WWindow final : IWindow
 	// the high-order word specifies a Y-coordinate of the cursor (HIWORD) 
 	unsigned int m_clientAreaCursor = 0;
 
+	mutable WindowListeners m_listeners;
+
+	mutable EventQueue m_events;
+
+	KeyState m_keys;
+
+	// the high surrogate of the UTF-16 pair WM_CHAR is reporting
+	wchar_t m_highSurrogate = 0;
+
+	mutable PointerHistory m_history;
+
+	mutable FramePacer m_pacer;
+
+	mutable WindowDamage m_damage;
+
+	mutable LiveResize m_resize;
+
+	// whether the window is in the modal loop moving or sizing it
+	bool m_sizeMove = false;
+
+	// the last recorded point of the mouse move history, in the display coordinates
+	MOUSEMOVEPOINT m_lastMovePoint{};
+
+	WindowTree::Node m_node;
+
+	// the title in UTF-8, cached when the window is created and by WM_SETTEXT
+	mutable WindowTitle m_title;
+
+	// whether the window was created with a title in the ANSI code page, getTitle returns it so
+	bool const m_ansi;
+
+	// keeps a window alive until WM_NCDESTROY, GWLP_USERDATA points to it
+	std::shared_ptr<WWindow> m_self{ nullptr };
+
 private:
-	WWindow(char const* title, short width, short height, int style, HWND hParent) noexcept
+	WWindow(char const* title, short width, short height, int style, HWND hParent, WEventThread& thread) noexcept
 		: m_handle(wCreateWindowA(title, width, height, style, hParent))
+		, m_thread(thread)
 		, m_clientAreaSize(height << 16 | width)
+		, m_ansi(true)
 	{
+		wStoreTitle(m_title, title);
 	}
 
-	WWindow(wchar_t const* title, short width, short height, int style, HWND hParent) noexcept
+	WWindow(wchar_t const* title, short width, short height, int style, HWND hParent, WEventThread& thread) noexcept
 		: m_handle(wCreateWindowW(title, width, height, style, hParent))
+		, m_thread(thread)
 		, m_clientAreaSize(height << 16 | width)
+		, m_ansi(false)
 	{
+		m_title.store(title);
 	}
 
-	static void loop(std::shared_ptr<WWindow> window)
+	static void attach(std::shared_ptr<WWindow> const& window) noexcept
 	{
-		HWND const hWnd = window ? window->m_handle : nullptr;
-		if (hWnd == nullptr) return;
-		SetWindowLongPtrW(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(&window));
-		MSG msg{};
-		while (msg.message != WM_QUIT && IsWindow(hWnd))
-		{
-			Sleep(1);
-			if (PeekMessageA(&msg, hWnd, 0, 0, PM_REMOVE))
-			{
-				TranslateMessage(&msg);
-				DispatchMessageA(&msg);
-			}
-		}
-		DestroyWindow(hWnd);
+		if (window->m_handle == nullptr) return;
+		window->m_self = window;
+		SetWindowLongPtrW(window->m_handle, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(&window->m_self));
+		// a parent lives on the same thread, it cannot be destroyed meanwhile
+		WindowTree& tree = window->m_thread.m_tree;
+		HWND const hParent = GetParent(window->m_handle);
+		tree.link(window->m_node, [&tree, hParent]() -> WindowTree::Node* {
+			if (hParent == nullptr) return &tree.root;
+			LONG_PTR const data = GetWindowLongPtrW(hParent, GWLP_USERDATA);
+			return data ? &(*reinterpret_cast<std::shared_ptr<WWindow> const*>(data))->m_node : nullptr;
+		}, window);
 	}
 
 public:
@@ -270,92 +598,153 @@ public:
 	{
 	}
 
-	static std::shared_ptr<WWindow> create(char const* title, int style, short width, short height, HWND hParent)
+	/**
+	 * create a window on an event thread
+	 * @param titled[in] whether the window has a title, otherwise the title is ignored
+	 * @return a future completed by the event thread once the native window exists
+	 */
+	template<typename Char>
+	static std::future<PWindow> createAsync(std::basic_string<Char> title, bool titled, int style, short width, short height, HWND hParent, WEventThread& thread)
 	{
-		std::shared_ptr<WWindow> shared_ptr{ nullptr };
-		std::thread([title, style, width, height, hParent, &shared_ptr]() {
-			shared_ptr = std::shared_ptr<WWindow>(new WWindow(title, width, height, style, hParent));
-			loop(shared_ptr);
-		}).detach();
-		while (!shared_ptr)
-		{
-			Sleep(20);
-		}
-		return shared_ptr;
+		std::shared_ptr<std::promise<PWindow>> promise = std::make_shared<std::promise<PWindow>>();
+		std::future<PWindow> future = promise->get_future();
+		thread.invoke([title, titled, style, width, height, hParent, &thread, promise]() {
+			std::shared_ptr<WWindow> window = allocateWindow<WWindow>([&](void* block) {
+				return new (block) WWindow(titled ? title.c_str() : nullptr, width, height, style, hParent, thread);
+			});
+			attach(window);
+			promise->set_value(window);
+		});
+		return future;
 	}
 
-	static std::shared_ptr<WWindow> create(wchar_t const* title, int style, short width, short height, HWND hParent)
+	/**
+	 * start the creation of all the windows before waiting for any of them
+	 */
+	static std::vector<PWindow> createMany(WindowSpec const* specs, size_t count, HWND hParent, WEventThread& thread)
 	{
-		std::shared_ptr<WWindow> shared_ptr{ nullptr };
-		std::thread([title, style, width, height, hParent, &shared_ptr]() {
-			shared_ptr = std::shared_ptr<WWindow>(new WWindow(title, width, height, style, hParent));
-			loop(shared_ptr);
-		}).detach();
-		while (!shared_ptr)
+		std::vector<std::future<PWindow>> futures;
+		futures.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			WindowSpec const& spec = specs[i];
+			futures.emplace_back(spec.title != nullptr || spec.unicode == nullptr
+				? createAsync(std::string(spec.title ? spec.title : ""), spec.title != nullptr, spec.style, spec.width, spec.height, hParent, thread)
+				: createAsync(std::wstring(spec.unicode), true, spec.style, spec.width, spec.height, hParent, thread));
+		}
+		std::vector<PWindow> windows;
+		windows.reserve(count);
+		for (std::future<PWindow>& future : futures)
 		{
-			Sleep(20);
+			windows.emplace_back(future.get());
 		}
-		return shared_ptr;
+		return windows;
+	}
+
+	static PWindow create(char const* title, int style, short width, short height, HWND hParent, WEventThread& thread)
+	{
+		return createAsync(std::string(title ? title : ""), title != nullptr, style, width, height, hParent, thread).get();
+	}
+
+	static PWindow create(wchar_t const* title, int style, short width, short height, HWND hParent, WEventThread& thread)
+	{
+		return createAsync(std::wstring(title ? title : L""), title != nullptr, style, width, height, hParent, thread).get();
 	}
 
 	PWindow create(char const* title, int style, short width, short height) const override
 	{
-		return PWindow(create(title, style, width, height, m_handle));
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return create(title, style, width, height, m_handle, m_thread);
 	}
 
 	PWindow create(wchar_t const* title, int style, short width, short height) const override
 	{
-		return PWindow(create(title, style, width, height, m_handle));
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return create(title, style, width, height, m_handle, m_thread);
 	}
 
 	PWindow create(int style, short width, short height) const override
 	{
-		return PWindow(create(static_cast<wchar_t const*>(nullptr), style, width, height, m_handle));
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return create(static_cast<wchar_t const*>(nullptr), style, width, height, m_handle, m_thread);
+	}
+
+	std::future<PWindow> createAsync(std::string title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return createAsync(std::move(title), true, style, width, height, m_handle, m_thread);
+	}
+
+	std::future<PWindow> createAsync(std::wstring title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return createAsync(std::move(title), true, style, width, height, m_handle, m_thread);
+	}
+
+	std::future<PWindow> createAsync(int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return createAsync(std::wstring(), false, style, width, height, m_handle, m_thread);
+	}
+
+	std::vector<PWindow> createMany(WindowSpec const* specs, size_t count) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEMANY);
+		return createMany(specs, count, m_handle, m_thread);
 	}
 
 	void show() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_SHOW);
 		ShowWindow(m_handle, SW_RESTORE);
 		SetForegroundWindow(m_handle);
 	}
 
 	void minimize() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_MINIMIZE);
 		ShowWindow(m_handle, SW_MINIMIZE);
 	}
 
 	void hide() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_HIDE);
 		ShowWindow(m_handle, SW_HIDE);
 	}
 
 	void close() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_CLOSE);
 		PostMessageA(m_handle, WM_CLOSE, 0, 0);
 	}
 
 	bool isClosed() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_ISCLOSED);
 		return IsWindow(m_handle) == 0;
 	}
 
 	bool isVisible() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_ISVISIBLE);
 		return IsIconic(m_handle) == 0 && IsWindowVisible(m_handle) != 0;
 	}
 
 	bool isHidden() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_ISHIDDEN);
 		return IsWindowVisible(m_handle);
 	}
 
 	bool isActive() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_ISACTIVE);
 		return GetForegroundWindow() == m_handle;
 	}
 
 	void getClientSize(short& width, short& height) const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_GETCLIENTSIZE);
 		short const* pPoint = static_cast<short const*>(static_cast<void const*>(&m_clientAreaSize));
 		width = pPoint[0];
 		height = pPoint[1];
@@ -363,6 +752,7 @@ public:
 
 	void getClientCursorPos(short& x, short& y) const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_GETCLIENTCURSORPOS);
 		short const* pPoint = static_cast<short const*>(static_cast<void const*>(&m_clientAreaCursor));
 		x = pPoint[0];
 		y = pPoint[1];
@@ -370,7 +760,8 @@ public:
 
 	Title getTitle() const noexcept override
 	{
-		if (IsWindowUnicode(m_handle) == 0)
+		WINSTRUMENT_CALL(WCALL_GETTITLE);
+		if (m_ansi)
 		{
 			std::string title(GetWindowTextLengthA(m_handle) + 1, '\0');
 			GetWindowTextA(m_handle, const_cast<LPSTR>(title.data()), title.capacity());
@@ -381,22 +772,225 @@ public:
 		return title;
 	}
 
+	size_t getTitle(char* buffer, size_t capacity) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETTITLE);
+		return m_title.copy(buffer, capacity);
+	}
+
 	void setTitle(char const* title) const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_SETTITLE);
 		SetWindowTextA(m_handle, title);
 	}
 
 	void setTitle(wchar_t const* title) const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_SETTITLE);
 		SetWindowTextW(m_handle, title);
 	}
 
 	PWindow getParent() const override
 	{
-		HWND hParent = GetParent(m_handle);
-		return hParent
-			? *reinterpret_cast<std::shared_ptr<WWindow> const*>(GetWindowLongPtrA(hParent, GWLP_USERDATA))
-			: root_window;
+		WINSTRUMENT_CALL(WCALL_GETPARENT);
+		return m_thread.m_tree.parent(m_node);
+	}
+
+	size_t getChildren(PWindow* children, size_t capacity) const override
+	{
+		WINSTRUMENT_CALL(WCALL_GETCHILDREN);
+		return m_thread.m_tree.children(m_node, children, capacity);
+	}
+
+	size_t getPointerHistory(PointerSample* samples, size_t capacity) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETPOINTERHISTORY);
+		return m_history.read(samples, capacity);
+	}
+
+	size_t takeDamage(WindowRect* rects, size_t capacity) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_TAKEDAMAGE);
+		return m_damage.take(rects, capacity);
+	}
+
+	void requestFrames(bool enabled) const override
+	{
+		WINSTRUMENT_CALL(WCALL_REQUESTFRAMES);
+		if (m_pacer.request(enabled) == enabled) return;
+		// the thread of the window orders it with the destruction of the window
+		HWND hWnd = m_handle;
+		FramePacer* pacer = &m_pacer;
+		WFrameScheduler& scheduler = m_thread.m_scheduler;
+		m_thread.invoke([hWnd, pacer, &scheduler, enabled]() {
+			if (!enabled) scheduler.remove(hWnd);
+			else if (IsWindow(hWnd)) scheduler.add(hWnd, pacer);
+		});
+	}
+
+	FrameStats getFrameStats() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETFRAMESTATS);
+		return m_pacer.stats();
+	}
+
+	PSurface createSurface(short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATESURFACE);
+		if (width <= 0 || height <= 0) return nullptr;
+		std::shared_ptr<WSurface> surface = std::make_shared<WSurface>(m_handle, width, height);
+		return surface->valid() ? surface : nullptr;
+	}
+
+	bool isKeyDown(unsigned char key) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_ISKEYDOWN);
+		return m_keys.test(key);
+	}
+
+	bool isLiveResizing() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_ISLIVERESIZING);
+		return m_resize.live();
+	}
+
+	size_t drainEvents(Event* events, size_t capacity) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_DRAINEVENTS);
+		return m_events.drain(events, capacity);
+	}
+
+	/**
+	 * @see recordEvents
+	 */
+	bool record(FILE* file) const noexcept
+	{
+		return m_events.record(file);
+	}
+
+	/**
+	 * post a recorded event to the window as the system posts its native message, so the window procedure handles it,
+	 * the text comes from TranslateMessage translating the keys and the close requests are left out
+	 * @param event[in] the recorded event
+	 * @return whether the event was posted
+	 */
+	bool replay(Event const& event) const noexcept
+	{
+		// the window procedure reads no rectangle from WM_SIZING, the default procedure may
+		static RECT sizing{ 0, 0, 0, 0 };
+		HWND const hWnd = m_handle;
+		LPARAM const position = MAKELPARAM(event.x, event.y);
+		switch (event.type)
+		{
+		case WEVENT_KEYDOWN:
+		case WEVENT_KEYUP:
+			{
+				// the repeat count and the scan code TranslateMessage translates the key with
+				LPARAM const scan = static_cast<LPARAM>(MapVirtualKeyW(static_cast<unsigned char>(event.code), MAPVK_VK_TO_VSC)) << 16;
+				return event.type == WEVENT_KEYDOWN
+					? PostMessageW(hWnd, WM_KEYDOWN, static_cast<unsigned char>(event.code), 1 | scan) != 0
+					: PostMessageW(hWnd, WM_KEYUP, static_cast<unsigned char>(event.code), 1 | scan | 0xc0000000) != 0;
+			}
+
+		case WEVENT_BUTTONDOWN:
+			return PostMessageW(hWnd, event.code == WBUTTON_LEFT ? WM_LBUTTONDOWN : event.code == WBUTTON_MIDDLE ? WM_MBUTTONDOWN : WM_RBUTTONDOWN, 0, position) != 0;
+
+		case WEVENT_BUTTONUP:
+			return PostMessageW(hWnd, event.code == WBUTTON_LEFT ? WM_LBUTTONUP : event.code == WBUTTON_MIDDLE ? WM_MBUTTONUP : WM_RBUTTONUP, 0, position) != 0;
+
+		case WEVENT_MOTION:
+			return PostMessageW(hWnd, WM_MOUSEMOVE, 0, position) != 0;
+
+		case WEVENT_WHEEL:
+			// the window procedure takes the position of a wheel event from the last motion
+			return PostMessageW(hWnd, WM_MOUSEWHEEL, MAKEWPARAM(0, event.code), 0) != 0;
+
+		case WEVENT_RESIZE:
+			return PostMessageW(hWnd, WM_SIZE, SIZE_RESTORED, position) != 0;
+
+		case WEVENT_LIVERESIZE:
+			if (event.code)
+			{
+				return PostMessageW(hWnd, WM_ENTERSIZEMOVE, 0, 0) && PostMessageW(hWnd, WM_SIZING, 0, reinterpret_cast<LPARAM>(&sizing));
+			}
+			return PostMessageW(hWnd, WM_EXITSIZEMOVE, 0, 0) != 0;
+
+		case WEVENT_FOCUS:
+			return PostMessageW(hWnd, WM_ACTIVATE, event.code ? WA_ACTIVE : WA_INACTIVE, 0) != 0;
+
+		default:
+			return false;
+		}
+	}
+
+	// the Win32 calls take effect when they return, there is no request buffer
+	void flush() const noexcept override { WINSTRUMENT_CALL(WCALL_FLUSH); }
+
+	void openBatch() const noexcept override { WINSTRUMENT_CALL(WCALL_OPENBATCH); }
+
+	void endBatch() const noexcept override { WINSTRUMENT_CALL(WCALL_ENDBATCH); }
+
+	void subscribe(PWindowListener listener) const override
+	{
+		WINSTRUMENT_CALL(WCALL_SUBSCRIBE);
+		m_listeners.add(static_cast<PWindowListener&&>(listener));
+	}
+
+	void unsubscribe(PWindowListener const& listener) const override
+	{
+		WINSTRUMENT_CALL(WCALL_UNSUBSCRIBE);
+		m_listeners.remove(listener);
+	}
+
+	/**
+	 * report the client area size, called by the thread of the window only
+	 */
+	void notifyResize() noexcept
+	{
+		short width = LOWORD(m_clientAreaSize), height = HIWORD(m_clientAreaSize);
+		m_events.push(Event::make(WEVENT_RESIZE, 0, width, height));
+		m_listeners.notify([this, width, height](IWindowListener& listener) { listener.onResize(*this, width, height); });
+	}
+
+	void notifyLiveResize(bool active) noexcept
+	{
+		m_events.push(Event::make(WEVENT_LIVERESIZE, active, LOWORD(m_clientAreaSize), HIWORD(m_clientAreaSize)));
+		m_listeners.notify([this, active](IWindowListener& listener) { listener.onLiveResize(*this, active); });
+	}
+
+	/**
+	 * record the positions the system coalesced into a WM_MOUSEMOVE, then the position it reports
+	 * @param x[in] the x-coordinate of the client area cursor position
+	 * @param y[in] the y-coordinate of the client area cursor position
+	 * @param time[in] the steady clock time of the message in microseconds
+	 */
+	void recordMotion(short x, short y, unsigned long long time) noexcept
+	{
+		DWORD const tick = static_cast<DWORD>(GetMessageTime());
+		POINT point{ x, y };
+		ClientToScreen(m_handle, &point);
+		MOUSEMOVEPOINT current{ static_cast<int>(point.x & 0xffff), static_cast<int>(point.y & 0xffff), tick, 0 };
+		MOUSEMOVEPOINT points[64];
+		int count = m_lastMovePoint.time
+			? GetMouseMovePointsEx(sizeof current, &current, points, 64, GMMP_USE_DISPLAY_POINTS)
+			: 0;
+		// the points are the most recent first, the first one is the current position
+		int older = 1;
+		while (older < count
+			&& static_cast<LONG>(points[older].time - m_lastMovePoint.time) >= 0
+			&& !(points[older].time == m_lastMovePoint.time && points[older].x == m_lastMovePoint.x && points[older].y == m_lastMovePoint.y))
+		{
+			++older;
+		}
+		for (int i = older - 1; i > 0; --i)
+		{
+			// the display points wrap the negative coordinates of the virtual screen
+			POINT coalesced{ points[i].x > 32767 ? points[i].x - 65536 : points[i].x, points[i].y > 32767 ? points[i].y - 65536 : points[i].y };
+			ScreenToClient(m_handle, &coalesced);
+			m_history.record(static_cast<short>(coalesced.x), static_cast<short>(coalesced.y), time - (tick - points[i].time) * 1000ull);
+		}
+		m_history.record(x, y, time);
+		m_lastMovePoint = current;
 	}
 
 	void resize() noexcept
@@ -422,20 +1016,107 @@ static int window_proc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam, LONG_P
 		return 0;
 
 	case WM_DESTROY:
-		PostQuitMessage(0);
+		if (p_window)
+		{
+			p_window->m_thread.m_scheduler.remove(hWnd);
+			p_window->m_thread.m_tree.unlink(p_window->m_node);
+			p_window->m_events.push(Event::make(WEVENT_CLOSE));
+			p_window->m_listeners.notify([p_window](IWindowListener& listener) { listener.onClose(*p_window); });
+		}
 		return 0;
 
+	case WM_NCDESTROY:
+		if (lpUserData)
+		{
+			SetWindowLongPtrW(hWnd, GWLP_USERDATA, 0);
+			std::shared_ptr<WWindow> self = static_cast<std::shared_ptr<WWindow>&&>(*reinterpret_cast<std::shared_ptr<WWindow>*>(lpUserData));
+		}
+		break;
+
+	case WM_SETTEXT:
+		// the text reaches the wide window procedure in UTF-16, whichever call set it
+		if (p_window && lParam)
+		{
+			p_window->m_title.store(reinterpret_cast<wchar_t const*>(lParam));
+		}
+		break;
+
 	case WM_SIZE:
 		if (p_window)
 		{
 			p_window->m_clientAreaSize = lParam & 0xffffffff;
+			if (p_window->m_resize.hold(p_window->m_thread.m_scheduler.m_interval * 1000ull)) return 0;
+			p_window->notifyResize();
+		}
+		return 0;
+
+	case WM_ENTERSIZEMOVE:
+		if (p_window)
+		{
+			p_window->m_sizeMove = true;
+		}
+		return 0;
+
+	case WM_SIZING:
+		// a drag moving the window only is no live resize
+		if (p_window && p_window->m_sizeMove && p_window->m_resize.begin())
+		{
+			// the modal loop of the drag still dispatches the timer messages
+			SetTimer(hWnd, IDT_LIVERESIZE, p_window->m_thread.m_scheduler.m_interval, nullptr);
+			p_window->notifyLiveResize(true);
+		}
+		break;
+
+	case WM_TIMER:
+		if (wParam != IDT_LIVERESIZE) break;
+		if (p_window && p_window->m_resize.release())
+		{
+			p_window->notifyResize();
+		}
+		return 0;
+
+	case WM_EXITSIZEMOVE:
+		if (p_window)
+		{
+			p_window->m_sizeMove = false;
+			bool held;
+			if (p_window->m_resize.end(held))
+			{
+				KillTimer(hWnd, IDT_LIVERESIZE);
+				if (held)
+				{
+					p_window->notifyResize();
+				}
+				p_window->notifyLiveResize(false);
+			}
 		}
 		return 0;
 
 	case WM_ACTIVATE:
+		if (p_window)
+		{
+			bool active = LOWORD(wParam) != WA_INACTIVE;
+			if (!active)
+			{
+				p_window->m_keys.clear();
+			}
+			p_window->m_events.push(Event::make(WEVENT_FOCUS, active));
+			p_window->m_listeners.notify([p_window, active](IWindowListener& listener) { listener.onFocus(*p_window, active); });
+		}
 		return 0;
 
 	case WM_PAINT:
+		{
+			// validating the update region stops the system from sending WM_PAINT again
+			PAINTSTRUCT ps;
+			BeginPaint(hWnd, &ps);
+			if (p_window)
+			{
+				RECT const& rect = ps.rcPaint;
+				p_window->m_damage.add(static_cast<short>(rect.left), static_cast<short>(rect.top), static_cast<short>(rect.right - rect.left), static_cast<short>(rect.bottom - rect.top));
+			}
+			EndPaint(hWnd, &ps);
+		}
 		return 0;
 
 	case WM_MENUCOMMAND:
@@ -449,6 +1130,86 @@ static int window_proc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam, LONG_P
 		if (p_window)
 		{
 			p_window->m_clientAreaCursor = lParam & 0xffffffff;
+			short x = LOWORD(lParam), y = HIWORD(lParam);
+			Event event = Event::make(WEVENT_MOTION, 0, x, y);
+			p_window->recordMotion(x, y, event.time);
+			p_window->m_events.push(event);
+			p_window->m_listeners.notify([p_window, x, y](IWindowListener& listener) { listener.onPointerMove(*p_window, x, y); });
+		}
+		return 0;
+
+	case WM_KEYDOWN:
+	case WM_KEYUP:
+	case WM_SYSKEYDOWN:
+	case WM_SYSKEYUP:
+		if (p_window)
+		{
+			short key = static_cast<short>(wParam & 0xff);
+			bool down = Msg == WM_KEYDOWN || Msg == WM_SYSKEYDOWN;
+			short const* cursor = reinterpret_cast<short const*>(&p_window->m_clientAreaCursor);
+			p_window->m_keys.set(static_cast<unsigned char>(key), down);
+			p_window->m_events.push(Event::make(down ? WEVENT_KEYDOWN : WEVENT_KEYUP, key, cursor[0], cursor[1]));
+			p_window->m_listeners.notify([p_window, key, down](IWindowListener& listener) { listener.onKey(*p_window, key, down); });
+		}
+		// the system keys drive the window menu and Alt+F4
+		return Msg == WM_KEYDOWN || Msg == WM_KEYUP ? 0 : -1;
+
+	case WM_CHAR:
+		if (p_window)
+		{
+			// every window is Unicode, a character beyond the BMP comes as a UTF-16 pair
+			wchar_t unit = static_cast<wchar_t>(wParam);
+			if (unit >= 0xd800 && unit < 0xdc00)
+			{
+				p_window->m_highSurrogate = unit;
+				return 0;
+			}
+			char32_t const codepoint = unit >= 0xdc00 && unit < 0xe000 && p_window->m_highSurrogate
+				? 0x10000 + ((p_window->m_highSurrogate - 0xd800) << 10) + (unit - 0xdc00)
+				: unit;
+			p_window->m_highSurrogate = 0;
+			p_window->m_events.push(Event::text(codepoint));
+			p_window->m_listeners.notify([p_window, codepoint](IWindowListener& listener) { listener.onText(*p_window, codepoint); });
+		}
+		return 0;
+
+	case WM_LBUTTONDOWN:
+	case WM_MBUTTONDOWN:
+	case WM_RBUTTONDOWN:
+		if (p_window)
+		{
+			short button = Msg == WM_LBUTTONDOWN ? WBUTTON_LEFT : Msg == WM_MBUTTONDOWN ? WBUTTON_MIDDLE : WBUTTON_RIGHT;
+			p_window->m_events.push(Event::make(WEVENT_BUTTONDOWN, button, LOWORD(lParam), HIWORD(lParam)));
+		}
+		return 0;
+
+	case WM_LBUTTONUP:
+	case WM_MBUTTONUP:
+	case WM_RBUTTONUP:
+		if (p_window)
+		{
+			short button = Msg == WM_LBUTTONUP ? WBUTTON_LEFT : Msg == WM_MBUTTONUP ? WBUTTON_MIDDLE : WBUTTON_RIGHT;
+			p_window->m_events.push(Event::make(WEVENT_BUTTONUP, button, LOWORD(lParam), HIWORD(lParam)));
+		}
+		return 0;
+
+	case WM_MOUSEWHEEL:
+		if (p_window)
+		{
+			// the position of WM_MOUSEWHEEL is in the screen coordinates
+			short const* cursor = reinterpret_cast<short const*>(&p_window->m_clientAreaCursor);
+			p_window->m_events.push(Event::make(WEVENT_WHEEL, GET_WHEEL_DELTA_WPARAM(wParam), cursor[0], cursor[1]));
+		}
+		return 0;
+
+	case WM_EVENTTHREADFRAME:
+		if (p_window)
+		{
+			FrameStats stats;
+			if (p_window->m_pacer.frame(IsWindowVisible(hWnd) && !IsIconic(hWnd), stats))
+			{
+				p_window->m_listeners.notify([p_window, &stats](IWindowListener& listener) { listener.onFrame(*p_window, stats); });
+			}
 		}
 		return 0;
 
@@ -458,16 +1219,11 @@ static int window_proc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam, LONG_P
 	return -1;
 }
 
-static LRESULT WINAPI WindowProcA(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam)
-{
-	LRESULT result = window_proc(hWnd, Msg, wParam, lParam, GetWindowLongPtrA(hWnd, GWLP_USERDATA));
-	return result == -1
-		? DefWindowProcA(hWnd, Msg, wParam, lParam)
-		: result;
-}
-
 static LRESULT WINAPI WindowProcW(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam)
 {
+	// the sent messages reach the window procedure without going through the message loop
+	WTRACE_SPAN("dispatch", Msg);
+	WINSTRUMENT_NATIVE(Msg);
 	LRESULT result = window_proc(hWnd, Msg, wParam, lParam, GetWindowLongPtrW(hWnd, GWLP_USERDATA));
 	return result == -1
 		? DefWindowProcW(hWnd, Msg, wParam, lParam)
@@ -476,34 +1232,90 @@ static LRESULT WINAPI WindowProcW(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lPa
 
 struct WRootWindow final : IWindow
 {
-	constexpr WRootWindow() noexcept = default;
+	// outlives the threads, their windows stop their frames when they are destroyed
+	WFrameScheduler m_scheduler;
+	// outlives the threads too, their windows unlink themselves when they are destroyed
+	WindowTree m_tree;
+	// the top-level windows are sharded across the threads, a child window goes to the thread of its parent
+	std::vector<std::unique_ptr<WEventThread>> m_threads;
+	mutable std::atomic<unsigned int> m_next{ 0 };
+	// the computer name
+	WindowTitle m_title;
+
+	WRootWindow()
+		: m_scheduler(frame_rate)
+	{
+		wchar_t name[MAX_COMPUTERNAME_LENGTH + 1]{};
+		DWORD size = MAX_COMPUTERNAME_LENGTH + 1;
+		GetComputerNameW(name, &size);
+		m_title.store(name);
+		unsigned int threads = event_threads;
+		for (unsigned int i = 0; i == 0 || i < threads; ++i)
+		{
+			m_threads.emplace_back(new WEventThread(m_scheduler, m_tree));
+		}
+	}
 
 	~WRootWindow() override
 	{
 	}
 
+	WEventThread& nextThread() const noexcept
+	{
+		return *m_threads[m_next++ % m_threads.size()];
+	}
+
 	PWindow create(char const* title, int style, short width, short height) const override
 	{
-		return PWindow(WWindow::create(title, style, width, height, HWND_DESKTOP));
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return PWindow(WWindow::create(title, style, width, height, HWND_DESKTOP, nextThread()));
 	}
 
 	PWindow create(wchar_t const* title, int style, short width, short height) const override
 	{
-		return PWindow(WWindow::create(title, style, width, height, HWND_DESKTOP));
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return PWindow(WWindow::create(title, style, width, height, HWND_DESKTOP, nextThread()));
 	}
 
 	PWindow create(int style, short width, short height) const override
 	{
-		return PWindow(WWindow::create(static_cast<wchar_t const*>(nullptr), style, width, height, HWND_DESKTOP));
+		WINSTRUMENT_CALL(WCALL_CREATE);
+		return PWindow(WWindow::create(static_cast<wchar_t const*>(nullptr), style, width, height, HWND_DESKTOP, nextThread()));
+	}
+
+	std::future<PWindow> createAsync(std::string title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return WWindow::createAsync(std::move(title), true, style, width, height, HWND_DESKTOP, nextThread());
+	}
+
+	std::future<PWindow> createAsync(std::wstring title, int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return WWindow::createAsync(std::move(title), true, style, width, height, HWND_DESKTOP, nextThread());
+	}
+
+	std::future<PWindow> createAsync(int style, short width, short height) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+		return WWindow::createAsync(std::wstring(), false, style, width, height, HWND_DESKTOP, nextThread());
+	}
+
+	std::vector<PWindow> createMany(WindowSpec const* specs, size_t count) const override
+	{
+		WINSTRUMENT_CALL(WCALL_CREATEMANY);
+		return WWindow::createMany(specs, count, HWND_DESKTOP, nextThread());
 	}
 
 	void show() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_SHOW);
 		SendMessageA(FindWindowA("Shell_TrayWnd", nullptr), WM_COMMAND, 419, 0);
 	}
 
 	void minimize() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_MINIMIZE);
 		SendMessageA(FindWindowA("Shell_TrayWnd", nullptr), WM_COMMAND, 416, 0);
 	}
 
@@ -517,16 +1329,22 @@ struct WRootWindow final : IWindow
 
 	bool isHidden() const noexcept override { return false; }
 
-	bool isActive() const noexcept override { return GetForegroundWindow() == nullptr; }
+	bool isActive() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_ISACTIVE);
+		return GetForegroundWindow() == nullptr;
+	}
 
 	void getClientSize(short& width, short& height) const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_GETCLIENTSIZE);
 		width = GetSystemMetrics(SM_CXVIRTUALSCREEN);
 		height = GetSystemMetrics(SM_CYVIRTUALSCREEN);
 	}
 
 	void getClientCursorPos(short& x, short& y) const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_GETCLIENTCURSORPOS);
 		POINT point;
 		GetCursorPos(&point);
 		x = point.x;
@@ -535,23 +1353,140 @@ struct WRootWindow final : IWindow
 
 	Title getTitle() const noexcept override
 	{
+		WINSTRUMENT_CALL(WCALL_GETTITLE);
 		std::string title = std::string(16, '\0');
 		unsigned long n;
 		GetComputerNameA(const_cast<LPSTR>(title.data()), &n);
 		return title;
 	}
 
+	size_t getTitle(char* buffer, size_t capacity) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETTITLE);
+		return m_title.copy(buffer, capacity);
+	}
+
 	void setTitle(char const*) const noexcept override {}
 	void setTitle(wchar_t const*) const noexcept override {}
 
 	PWindow getParent() const noexcept override { return root_window; }
+
+	size_t getChildren(PWindow* children, size_t capacity) const override
+	{
+		WINSTRUMENT_CALL(WCALL_GETCHILDREN);
+		return m_tree.children(m_tree.root, children, capacity);
+	}
+
+	size_t getPointerHistory(PointerSample* samples, size_t capacity) const noexcept override { return 0; }
+
+	size_t takeDamage(WindowRect* rects, size_t capacity) const noexcept override { return 0; }
+
+	void requestFrames(bool enabled) const override {}
+
+	FrameStats getFrameStats() const noexcept override { return FrameStats{}; }
+
+	PSurface createSurface(short width, short height) const override { return nullptr; }
+
+	bool isKeyDown(unsigned char key) const noexcept override { return false; }
+
+	bool isLiveResizing() const noexcept override { return false; }
+
+	size_t drainEvents(Event* events, size_t capacity) const noexcept override { return 0; }
+
+	void flush() const noexcept override {}
+
+	void openBatch() const noexcept override {}
+
+	void endBatch() const noexcept override {}
+
+	void subscribe(PWindowListener listener) const override {}
+
+	void unsubscribe(PWindowListener const& listener) const override {}
 };
 
 EXTERN_C Window getRootWindow()
 {
 	if (root_window == nullptr)
 	{
-		root_window = std::make_shared<WRootWindow>();
+		std::shared_ptr<WRootWindow> root = std::make_shared<WRootWindow>();
+		root->m_tree.root.window = root;
+		root_window = root;
 	}
 	return *root_window;
 }
+
+PWindow getRootWindow(char const* display, int screen)
+{
+	// the desktop is the only display, its monitors share one root window
+	if (display != nullptr && *display != '\0') return nullptr;
+	getRootWindow();
+	return root_window;
+}
+
+EXTERN_C void setEventThreads(unsigned int threads)
+{
+	event_threads = threads;
+}
+
+EXTERN_C void setFrameRate(unsigned int hz)
+{
+	frame_rate = hz;
+}
+
+EXTERN_C void setAutoFlush(bool enabled)
+{
+	// the Win32 calls take effect when they return, there is no request buffer
+}
+
+EXTERN_C void setHibernation(unsigned int ms)
+{
+	// the system trims the minimized windows itself and the frame ticks skip the hidden ones
+}
+
+void setWindowMemory(std::pmr::memory_resource* resource)
+{
+	windowMemoryResource() = resource ? resource : defaultWindowMemory();
+}
+
+bool getInstrumentation(InstrumentationSnapshot& snapshot) noexcept
+{
+	return Instrumentation::take(snapshot);
+}
+
+void dumpInstrumentation(FILE* file, bool json) noexcept
+{
+	Instrumentation::dump(file, json);
+}
+
+void setInstrumentationDump(FILE* file, unsigned int interval, bool json)
+{
+	Instrumentation::schedule(file, interval, json);
+}
+
+void setTracing(bool enabled) noexcept
+{
+	Trace::get().enable(enabled);
+}
+
+bool exportTrace(FILE* file)
+{
+	return Trace::get().write(file);
+}
+
+bool recordEvents(Window window, FILE* file)
+{
+	WWindow const* p_window = dynamic_cast<WWindow const*>(&window);
+	return p_window ? p_window->record(file) : false;
+}
+
+size_t replayEvents(Window window, FILE* file, double speed)
+{
+	WWindow const* p_window = dynamic_cast<WWindow const*>(&window);
+	if (p_window == nullptr) return 0;
+	return replayEventFile(file, speed, [p_window](Event const& event) { p_window->replay(event); });
+}
+
+EXTERN_C void releaseRootWindow()
+{
+	root_window = nullptr;
+}
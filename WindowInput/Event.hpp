@@ -0,0 +1,90 @@
+#ifndef __EVENT_HPP
+#define __EVENT_HPP 1
+
+#include "../common.h"
+#include <chrono>
+
+#define WEVENT_NONE 0
+#define WEVENT_KEYDOWN 1
+#define WEVENT_KEYUP 2
+#define WEVENT_BUTTONDOWN 3
+#define WEVENT_BUTTONUP 4
+#define WEVENT_MOTION 5
+#define WEVENT_WHEEL 6
+#define WEVENT_RESIZE 7
+#define WEVENT_FOCUS 8
+#define WEVENT_CLOSE 9
+#define WEVENT_TEXT 10
+#define WEVENT_LIVERESIZE 11
+
+#define WBUTTON_LEFT 1
+#define WBUTTON_MIDDLE 2
+#define WBUTTON_RIGHT 3
+
+/**
+ * Normalized Input Event
+ */
+struct Event
+{
+	// the event type @see WEVENT_*
+	unsigned short type;
+
+	// WEVENT_KEY*: the key code of the backend
+	// WEVENT_BUTTON*: the button @see WBUTTON_*
+	// WEVENT_WHEEL: the wheel delta, positive away from the user
+	// WEVENT_FOCUS: 1 if the window has got the focus, 0 if it has lost it
+	// WEVENT_LIVERESIZE: 1 if a live resize has begun, 0 if it has ended
+	short code;
+
+	// the client area cursor position, or the client area size for WEVENT_RESIZE and WEVENT_LIVERESIZE,
+	// or the low and the high word of the UTF-32 code point for WEVENT_TEXT @see codepoint()
+	short x;
+	short y;
+
+	// the steady clock time, in microseconds, the backend received the event at
+	unsigned long long time;
+
+	/**
+	 * @return the steady clock time in microseconds
+	 */
+	static unsigned long long now() noexcept
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static Event make(unsigned short type, short code = 0, short x = 0, short y = 0) noexcept
+	{
+		return Event{ type, code, x, y, now() };
+	}
+
+	/**
+	 * @param codepoint[in] the UTF-32 code point of the typed character
+	 */
+	static Event text(char32_t codepoint) noexcept
+	{
+		return Event{ WEVENT_TEXT, 0, static_cast<short>(codepoint & 0xffff), static_cast<short>(codepoint >> 16), now() };
+	}
+
+	/**
+	 * @return the UTF-32 code point of a WEVENT_TEXT event
+	 */
+	char32_t codepoint() const noexcept
+	{
+		return static_cast<unsigned short>(x) | static_cast<char32_t>(static_cast<unsigned short>(y)) << 16;
+	}
+};
+
+/**
+ * Pointer Position Sample
+ */
+struct PointerSample
+{
+	// the client area cursor position
+	short x;
+	short y;
+
+	// the steady clock time, in microseconds, the pointer was there at
+	unsigned long long time;
+};
+
+#endif // !__EVENT_HPP
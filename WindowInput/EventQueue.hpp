@@ -0,0 +1,175 @@
+#ifndef __EVENTQUEUE_HPP
+#define __EVENTQUEUE_HPP 1
+
+#include "Event.hpp"
+#include "EventRecorder.hpp"
+#include "Instrumentation.hpp"
+#include "WindowMemory.hpp"
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+/**
+ * Bounded Ring Buffer
+ * single producer, multiple consumers, lock-free, every cell carries a sequence number
+ *
+ * @param T a trivially copyable type
+ * @param Capacity a power of two
+ */
+template<typename T, size_t Capacity>
+struct SpmcRing
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "the capacity must be a power of two");
+
+	SpmcRing() noexcept
+	{
+		for (size_t i = 0; i < Capacity; ++i)
+		{
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * called by the producer only
+	 * @return false if the ring is full
+	 */
+	bool push(T const& value) noexcept
+	{
+		size_t const position = m_tail.load(std::memory_order_relaxed);
+		Cell& cell = m_cells[position & (Capacity - 1)];
+		if (cell.sequence.load(std::memory_order_acquire) != position) return false;
+		cell.value = value;
+		cell.sequence.store(position + 1, std::memory_order_release);
+		m_tail.store(position + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	 * claim the ready values in one step
+	 * @param values[out] the popped values
+	 * @param count[in] the maximum number of values to pop
+	 * @return the number of the popped values
+	 */
+	size_t pop(T* values, size_t count) noexcept
+	{
+		size_t position = m_head.load(std::memory_order_relaxed);
+		size_t ready;
+		do
+		{
+			ready = 0;
+			while (ready < count && m_cells[(position + ready) & (Capacity - 1)].sequence.load(std::memory_order_acquire) == position + ready + 1)
+			{
+				++ready;
+			}
+			if (ready == 0) return 0;
+		} while (!m_head.compare_exchange_weak(position, position + ready, std::memory_order_relaxed));
+
+		for (size_t i = 0; i < ready; ++i)
+		{
+			Cell& cell = m_cells[(position + i) & (Capacity - 1)];
+			values[i] = cell.value;
+			cell.sequence.store(position + i + Capacity, std::memory_order_release);
+		}
+		return ready;
+	}
+
+	/**
+	 * @return the number of the values pushed and not popped yet, an estimate while the consumers pop
+	 */
+	size_t size() const noexcept
+	{
+		return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	Cell m_cells[Capacity];
+	alignas(64) std::atomic<size_t> m_head{ 0 };
+	alignas(64) std::atomic<size_t> m_tail{ 0 };
+};
+
+/**
+ * Input Event Queue of a Window
+ * the ring is allocated from the window memory by the first drain, so the windows nobody drains queue nothing,
+ * a full ring drops the new events, a recording gets every pushed event, dropped or not
+ */
+struct EventQueue
+{
+	using Ring = SpmcRing<Event, 256>;
+
+	~EventQueue()
+	{
+		if (Ring* ring = m_ring.load(std::memory_order_relaxed))
+		{
+			ring->~Ring();
+			m_resource->deallocate(ring, sizeof(Ring), alignof(Ring));
+		}
+	}
+
+	/**
+	 * called by the event thread of the window only
+	 */
+	void push(Event const& event) noexcept
+	{
+		WINSTRUMENT_EVENT(event.type);
+		m_recorder.record(event);
+		if (Ring* ring = m_ring.load(std::memory_order_acquire))
+		{
+			if (!ring->push(event))
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				WINSTRUMENT_COUNT(WCOUNTER_DROPPED);
+			}
+			WINSTRUMENT_DEPTH(WQUEUE_EVENTS, ring->size());
+		}
+	}
+
+	size_t drain(Event* events, size_t capacity) noexcept
+	{
+		Ring* ring = m_ring.load(std::memory_order_acquire);
+		if (ring == nullptr)
+		{
+			std::pmr::memory_resource* const resource = windowMemory();
+			Ring* created = new (resource->allocate(sizeof(Ring), alignof(Ring))) Ring();
+			if (m_ring.compare_exchange_strong(ring, created, std::memory_order_acq_rel))
+			{
+				// read by the destructor only, after every drain
+				m_resource = resource;
+				return 0;
+			}
+			created->~Ring();
+			resource->deallocate(created, sizeof(Ring), alignof(Ring));
+		}
+		return ring->pop(events, capacity);
+	}
+
+	/**
+	 * @return the number of the events dropped because the ring was full
+	 */
+	unsigned int dropped() const noexcept
+	{
+		return m_dropped.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @see recordEvents
+	 */
+	bool record(FILE* file) noexcept
+	{
+		return m_recorder.start(file);
+	}
+
+private:
+	std::atomic<Ring*> m_ring{ nullptr };
+	// the resource the ring was allocated from
+	std::pmr::memory_resource* m_resource = nullptr;
+	std::atomic<unsigned int> m_dropped{ 0 };
+	EventRecorder m_recorder;
+};
+
+#endif // !__EVENTQUEUE_HPP
@@ -0,0 +1,177 @@
+#ifndef __EVENTRECORDER_HPP
+#define __EVENTRECORDER_HPP 1
+
+#include "Event.hpp"
+#include "Window.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+/**
+ * start or stop recording the normalized events of a window into a file, @see EventFileHeader,
+ * a window records into one file at a time, starting a recording stops the previous one
+ *
+ * @param window[in] the window whose events to record
+ * @param file[in] a binary file open for writing, the caller closes it once the recording has stopped, null to stop
+ * @return whether the recording has started or stopped
+ */
+bool recordEvents(Window window, FILE* file);
+
+/**
+ * feed a recording to a window through the dispatch path of its backend, on the calling thread,
+ * the events the backend derives from others are derived again instead of replayed
+ *
+ * @param window[in] the window to replay the events into
+ * @param file[in] a binary file open for reading, positioned at the header
+ * @param speed[in] 1 replays at the recorded pace, 2 twice as fast, 0 as fast as possible
+ * @return the number of the events read from the recording, the left out ones included
+ */
+size_t replayEvents(Window window, FILE* file, double speed);
+
+#define WEVENTFILE_VERSION 1
+#define WEVENTFILE_BYTEORDER 0x01020304u
+
+/**
+ * Event File Header
+ * a header followed by the records until the end of the file, the records are appended as the events come,
+ * so a recording still being written or cut short reads as the records complete so far,
+ * every record lies at a multiple of its size and maps in memory as an array
+ */
+struct EventFileHeader
+{
+	// "WEVR"
+	char magic[4];
+	uint16_t version;
+	// the size of a record in bytes
+	uint16_t recordSize;
+	// WEVENTFILE_BYTEORDER in the byte order of the recording machine
+	uint32_t byteOrder;
+	uint32_t reserved;
+
+	static EventFileHeader make() noexcept
+	{
+		return EventFileHeader{ { 'W', 'E', 'V', 'R' }, WEVENTFILE_VERSION, 16, WEVENTFILE_BYTEORDER, 0 };
+	}
+
+	bool valid() const noexcept
+	{
+		return std::memcmp(magic, "WEVR", 4) == 0 && version == WEVENTFILE_VERSION && recordSize == 16 && byteOrder == WEVENTFILE_BYTEORDER;
+	}
+};
+
+/**
+ * Event File Record
+ * an Event with its time relative to the start of the recording
+ */
+struct EventRecord
+{
+	uint16_t type;
+	int16_t code;
+	int16_t x;
+	int16_t y;
+	// the microseconds since the start of the recording
+	uint64_t time;
+};
+
+static_assert(sizeof(EventFileHeader) == 16, "the header is 16 bytes");
+static_assert(sizeof(EventRecord) == 16, "a record is 16 bytes");
+
+/**
+ * Event Recorder of a Window
+ * written by the event thread of the window, started and stopped by any thread,
+ * a stopped recorder costs the event thread a relaxed load per event
+ */
+struct EventRecorder
+{
+	/**
+	 * @see recordEvents
+	 */
+	bool start(FILE* file) noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		close();
+		if (file == nullptr) return true;
+		EventFileHeader const header = EventFileHeader::make();
+		if (std::fwrite(&header, sizeof(header), 1, file) != 1) return false;
+		m_file = file;
+		m_start = Event::now();
+		m_active.store(true, std::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	 * called by the event thread of the window only
+	 */
+	void record(Event const& event) noexcept
+	{
+		if (!m_active.load(std::memory_order_relaxed)) return;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_file == nullptr) return;
+		EventRecord const record{ event.type, event.code, event.x, event.y, event.time > m_start ? event.time - m_start : 0 };
+		if (std::fwrite(&record, sizeof(record), 1, m_file) != 1)
+		{
+			// a full disk ends the recording instead of every event retrying
+			close();
+		}
+	}
+
+private:
+	std::atomic<bool> m_active{ false };
+	std::mutex m_mutex;
+	FILE* m_file = nullptr;
+	unsigned long long m_start = 0;
+
+	void close() noexcept
+	{
+		m_active.store(false, std::memory_order_relaxed);
+		if (m_file) std::fflush(m_file);
+		m_file = nullptr;
+	}
+};
+
+/**
+ * read a recording and inject its events at their recorded pace, @see replayEvents
+ *
+ * @param inject[in] called with every event, stamped with the time it is injected at
+ * @return the number of the read events, 0 if the file is no recording of this byte order
+ */
+template<typename Inject>
+size_t replayEventFile(FILE* file, double speed, Inject&& inject)
+{
+	EventFileHeader header;
+	if (file == nullptr || std::fread(&header, sizeof(header), 1, file) != 1 || !header.valid()) return 0;
+	EventRecord records[256];
+	size_t count = 0;
+	bool first = true;
+	uint64_t origin = 0;
+	std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+	// a record cut short at the end of the file is left out
+	while (size_t const read = std::fread(records, sizeof(EventRecord), 256, file))
+	{
+		for (size_t i = 0; i < read; ++i)
+		{
+			EventRecord const& record = records[i];
+			if (first)
+			{
+				// the replay begins with the first event instead of the idle time before it
+				origin = record.time;
+				first = false;
+			}
+			if (speed > 0 && record.time > origin)
+			{
+				std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double, std::micro>((record.time - origin) / speed)));
+			}
+			inject(Event{ record.type, record.code, record.x, record.y, Event::now() });
+			++count;
+		}
+		if (read < 256) break;
+	}
+	return count;
+}
+
+#endif // !__EVENTRECORDER_HPP
@@ -0,0 +1,96 @@
+#ifndef __FRAMEPACER_HPP
+#define __FRAMEPACER_HPP 1
+
+#include "Instrumentation.hpp"
+#include "Window.hpp"
+#include <atomic>
+#include <mutex>
+
+/**
+ * Frame Pacing State of a Window
+ * the scheduler claims a frame at every tick, the event thread of the window delivers it,
+ * a tick finding the previous frame undelivered is dropped rather than queued
+ */
+struct FramePacer
+{
+	/**
+	 * @return whether the frames were requested before
+	 */
+	bool request(bool enabled) noexcept
+	{
+		return m_requested.exchange(enabled);
+	}
+
+	bool requested() const noexcept
+	{
+		return m_requested;
+	}
+
+	/**
+	 * called by the scheduler
+	 * @return whether a frame has to be sent to the event thread of the window
+	 */
+	bool claim() noexcept
+	{
+		return m_requested && !m_pending.exchange(true);
+	}
+
+	/**
+	 * called by the event thread of the window
+	 * @param visible[in] whether the window is mapped and not minimized
+	 * @param stats[out] the statistics including the frame
+	 * @return whether the frame has to be delivered
+	 */
+	bool frame(bool visible, FrameStats& stats) noexcept
+	{
+		m_pending = false;
+		unsigned long long const now = Event::now();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_requested || !visible)
+		{
+			// the next frame of a window shown again does not measure the time it was hidden
+			m_stats.skipped += m_requested;
+			m_last = 0;
+			return false;
+		}
+		unsigned int const interval = m_last ? static_cast<unsigned int>(now - m_last) : 0;
+		m_last = now;
+		m_stats.interval = interval;
+		if (interval)
+		{
+			m_stats.average = m_stats.average ? m_stats.average - m_stats.average / 8 + interval / 8 : interval;
+			if (interval > m_stats.worst) m_stats.worst = interval;
+		}
+		m_stats.time = now;
+		++m_stats.frames;
+		stats = m_stats;
+		WINSTRUMENT_COUNT(WCOUNTER_FRAMES);
+		return true;
+	}
+
+	/**
+	 * called by the event thread of the window instead of frame while the previous frame is still being presented,
+	 * the interval of the next frame includes the missed one
+	 */
+	void miss() noexcept
+	{
+		m_pending = false;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stats.missed += m_requested;
+	}
+
+	FrameStats stats() const noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+private:
+	std::atomic<bool> m_requested{ false };
+	std::atomic<bool> m_pending{ false };
+	mutable std::mutex m_mutex;
+	FrameStats m_stats{};
+	unsigned long long m_last = 0;
+};
+
+#endif // !__FRAMEPACER_HPP
@@ -0,0 +1,390 @@
+#ifndef __INSTRUMENTATION_HPP
+#define __INSTRUMENTATION_HPP 1
+
+#include "Event.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+// the timed calls of the windows
+#define WCALL_CREATE 0
+#define WCALL_CREATEASYNC 1
+#define WCALL_CREATEMANY 2
+#define WCALL_SHOW 3
+#define WCALL_MINIMIZE 4
+#define WCALL_HIDE 5
+#define WCALL_CLOSE 6
+#define WCALL_GETCLIENTSIZE 7
+#define WCALL_GETCLIENTCURSORPOS 8
+#define WCALL_GETTITLE 9
+#define WCALL_SETTITLE 10
+#define WCALL_GETPARENT 11
+#define WCALL_GETCHILDREN 12
+#define WCALL_CREATESURFACE 13
+#define WCALL_DRAINEVENTS 14
+#define WCALL_TAKEDAMAGE 15
+#define WCALL_ISCLOSED 16
+#define WCALL_ISVISIBLE 17
+#define WCALL_ISHIDDEN 18
+#define WCALL_ISACTIVE 19
+#define WCALL_GETPOINTERHISTORY 20
+#define WCALL_ISKEYDOWN 21
+#define WCALL_ISLIVERESIZING 22
+#define WCALL_REQUESTFRAMES 23
+#define WCALL_GETFRAMESTATS 24
+#define WCALL_FLUSH 25
+#define WCALL_OPENBATCH 26
+#define WCALL_ENDBATCH 27
+#define WCALL_SUBSCRIBE 28
+#define WCALL_UNSUBSCRIBE 29
+#define WCALL_COUNT 30
+
+// the counters of the backends
+#define WCOUNTER_ROUNDTRIPS 0
+#define WCOUNTER_FLUSHES 1
+#define WCOUNTER_WAKEUPS 2
+#define WCOUNTER_FRAMES 3
+#define WCOUNTER_DROPPED 4
+#define WCOUNTER_COUNT 5
+
+// the queues whose depth is tracked
+#define WQUEUE_EVENTS 0
+#define WQUEUE_DISPATCH 1
+#define WQUEUE_COUNT 2
+
+// the native event types counted one by one, the X event types and the Win32 system messages,
+// the larger ones are counted together in the last
+#define WNATIVE_TYPES 1024
+
+#define WHISTOGRAM_BUCKETS 40
+
+/**
+ * Latency Histogram of a Call
+ * the bucket i counts the calls taking from 2^i to 2^(i+1) nanoseconds
+ */
+struct LatencyHistogram
+{
+	unsigned long long count;
+	// the sum and the maximum of the latencies in nanoseconds
+	unsigned long long total;
+	unsigned long long max;
+	unsigned long long buckets[WHISTOGRAM_BUCKETS];
+
+	/**
+	 * @param fraction[in] the fraction of the calls, 0.5 for the median
+	 * @return the upper bound of the bucket holding the percentile in nanoseconds, at most the maximum, 0 without calls
+	 */
+	unsigned long long percentile(double fraction) const noexcept
+	{
+		unsigned long long const rank = static_cast<unsigned long long>(fraction * count);
+		unsigned long long seen = 0;
+		for (unsigned int i = 0; i < WHISTOGRAM_BUCKETS; ++i)
+		{
+			seen += buckets[i];
+			if (seen > rank) return (2ull << i) < max ? 2ull << i : max;
+		}
+		return count ? max : 0;
+	}
+};
+
+/**
+ * Instrumentation Snapshot
+ * the values since the library was loaded, all zero unless the library was built with WINDOWINPUT_INSTRUMENT
+ */
+struct InstrumentationSnapshot
+{
+	LatencyHistogram calls[WCALL_COUNT];
+	unsigned long long counters[WCOUNTER_COUNT];
+	// the events dispatched per type @see WEVENT_NONE, WEVENT_*
+	unsigned long long events[WEVENT_LIVERESIZE + 1];
+	// the native events the backend picked up per type, an X event type or a Win32 message @see WNATIVE_TYPES
+	unsigned long long native[WNATIVE_TYPES];
+	// the deepest the queues have been
+	unsigned long long depths[WQUEUE_COUNT];
+};
+
+/**
+ * @param snapshot[out] the instrumentation values
+ * @return whether the library records them, built with WINDOWINPUT_INSTRUMENT
+ */
+bool getInstrumentation(InstrumentationSnapshot& snapshot) noexcept;
+
+/**
+ * write the instrumentation values
+ *
+ * @param file[in] the file to write to
+ * @param json[in] whether to write a JSON object rather than text lines
+ */
+void dumpInstrumentation(FILE* file, bool json) noexcept;
+
+/**
+ * write the instrumentation values periodically from a thread of the library
+ *
+ * @param file[in] the file to write to, null to stop the dumps
+ * @param interval[in] the time between two dumps in milliseconds
+ * @param json[in] whether to write JSON objects rather than text lines
+ */
+void setInstrumentationDump(FILE* file, unsigned int interval, bool json);
+
+/**
+ * Instrumentation Recorder
+ * relaxed atomic counters written by any thread, the recording macros expand to nothing
+ * unless WINDOWINPUT_INSTRUMENT is defined
+ */
+struct Instrumentation
+{
+	static Instrumentation& get() noexcept
+	{
+		static Instrumentation instance;
+		return instance;
+	}
+
+	void call(unsigned int call, unsigned long long latency) noexcept
+	{
+		Histogram& histogram = m_calls[call];
+		unsigned int bucket = 0;
+		while (bucket + 1 < WHISTOGRAM_BUCKETS && latency >> (bucket + 1)) ++bucket;
+		histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+		histogram.count.fetch_add(1, std::memory_order_relaxed);
+		histogram.total.fetch_add(latency, std::memory_order_relaxed);
+		raise(histogram.max, latency);
+	}
+
+	void count(unsigned int counter) noexcept
+	{
+		m_counters[counter].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void event(unsigned short type) noexcept
+	{
+		if (type <= WEVENT_LIVERESIZE) m_events[type].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void native(unsigned long type) noexcept
+	{
+		m_native[type < WNATIVE_TYPES ? type : WNATIVE_TYPES - 1].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void depth(unsigned int queue, unsigned long long depth) noexcept
+	{
+		raise(m_depths[queue], depth);
+	}
+
+	/**
+	 * @see getInstrumentation
+	 */
+	static bool take(InstrumentationSnapshot& snapshot) noexcept
+	{
+		snapshot = InstrumentationSnapshot{};
+#ifdef WINDOWINPUT_INSTRUMENT
+		get().snapshot(snapshot);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * @see dumpInstrumentation
+	 */
+	static void dump(FILE* file, bool json) noexcept
+	{
+		InstrumentationSnapshot snapshot;
+		take(snapshot);
+		write(file, snapshot, json);
+	}
+
+	/**
+	 * @see setInstrumentationDump, nothing is dumped without WINDOWINPUT_INSTRUMENT
+	 */
+	static void schedule(FILE* file, unsigned int interval, bool json)
+	{
+#ifdef WINDOWINPUT_INSTRUMENT
+		get().periodic(file, interval, json);
+#endif
+	}
+
+	void snapshot(InstrumentationSnapshot& snapshot) const noexcept
+	{
+		for (unsigned int i = 0; i < WCALL_COUNT; ++i)
+		{
+			Histogram const& histogram = m_calls[i];
+			LatencyHistogram& calls = snapshot.calls[i];
+			calls.count = histogram.count.load(std::memory_order_relaxed);
+			calls.total = histogram.total.load(std::memory_order_relaxed);
+			calls.max = histogram.max.load(std::memory_order_relaxed);
+			for (unsigned int j = 0; j < WHISTOGRAM_BUCKETS; ++j)
+			{
+				calls.buckets[j] = histogram.buckets[j].load(std::memory_order_relaxed);
+			}
+		}
+		for (unsigned int i = 0; i < WCOUNTER_COUNT; ++i)
+		{
+			snapshot.counters[i] = m_counters[i].load(std::memory_order_relaxed);
+		}
+		for (unsigned int i = 0; i <= WEVENT_LIVERESIZE; ++i)
+		{
+			snapshot.events[i] = m_events[i].load(std::memory_order_relaxed);
+		}
+		for (unsigned int i = 0; i < WNATIVE_TYPES; ++i)
+		{
+			snapshot.native[i] = m_native[i].load(std::memory_order_relaxed);
+		}
+		for (unsigned int i = 0; i < WQUEUE_COUNT; ++i)
+		{
+			snapshot.depths[i] = m_depths[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * write a snapshot, the names are the ones of the WCALL_*, WCOUNTER_*, WEVENT_* and WQUEUE_* macros,
+	 * the native types are written by number and only those picked up
+	 */
+	static void write(FILE* file, InstrumentationSnapshot const& snapshot, bool json) noexcept
+	{
+		static char const* const calls[WCALL_COUNT] {
+			"create", "createAsync", "createMany", "show", "minimize", "hide", "close", "getClientSize",
+			"getClientCursorPos", "getTitle", "setTitle", "getParent", "getChildren", "createSurface", "drainEvents", "takeDamage",
+			"isClosed", "isVisible", "isHidden", "isActive", "getPointerHistory", "isKeyDown", "isLiveResizing", "requestFrames",
+			"getFrameStats", "flush", "openBatch", "endBatch", "subscribe", "unsubscribe",
+		};
+		static char const* const counters[WCOUNTER_COUNT] { "roundtrips", "flushes", "wakeups", "frames", "dropped" };
+		static char const* const events[WEVENT_LIVERESIZE + 1] {
+			"none", "keydown", "keyup", "buttondown", "buttonup", "motion", "wheel", "resize", "focus", "close", "text", "liveresize",
+		};
+		static char const* const queues[WQUEUE_COUNT] { "events", "dispatch" };
+
+		std::fprintf(file, json ? "{\"calls\":{" : "calls (count mean p50 p99 max, ns)\n");
+		for (unsigned int i = 0; i < WCALL_COUNT; ++i)
+		{
+			LatencyHistogram const& call = snapshot.calls[i];
+			unsigned long long const mean = call.count ? call.total / call.count : 0;
+			std::fprintf(file, json ? "%s\"%s\":{\"count\":%llu,\"mean\":%llu,\"p50\":%llu,\"p99\":%llu,\"max\":%llu}" : "%s  %-20s %llu %llu %llu %llu %llu\n",
+				json && i ? "," : "", calls[i], call.count, mean, call.percentile(0.5), call.percentile(0.99), call.max);
+		}
+		std::fprintf(file, json ? "},\"counters\":{" : "counters\n");
+		for (unsigned int i = 0; i < WCOUNTER_COUNT; ++i)
+		{
+			std::fprintf(file, json ? "%s\"%s\":%llu" : "%s  %-20s %llu\n", json && i ? "," : "", counters[i], snapshot.counters[i]);
+		}
+		std::fprintf(file, json ? "},\"events\":{" : "events\n");
+		for (unsigned int i = 0; i <= WEVENT_LIVERESIZE; ++i)
+		{
+			std::fprintf(file, json ? "%s\"%s\":%llu" : "%s  %-20s %llu\n", json && i ? "," : "", events[i], snapshot.events[i]);
+		}
+		std::fprintf(file, json ? "},\"native\":{" : "native\n");
+		bool first = true;
+		for (unsigned int i = 0; i < WNATIVE_TYPES; ++i)
+		{
+			if (snapshot.native[i] == 0) continue;
+			std::fprintf(file, json ? "%s\"%u\":%llu" : "%s  %-20u %llu\n", json && !first ? "," : "", i, snapshot.native[i]);
+			first = false;
+		}
+		std::fprintf(file, json ? "},\"depths\":{" : "depths\n");
+		for (unsigned int i = 0; i < WQUEUE_COUNT; ++i)
+		{
+			std::fprintf(file, json ? "%s\"%s\":%llu" : "%s  %-20s %llu\n", json && i ? "," : "", queues[i], snapshot.depths[i]);
+		}
+		if (json) std::fputs("}}\n", file);
+		std::fflush(file);
+	}
+
+	/**
+	 * start, restart or stop the periodic dumps @see setInstrumentationDump
+	 */
+	void periodic(FILE* file, unsigned int interval, bool json)
+	{
+		std::lock_guard<std::mutex> control(m_control);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_file = nullptr;
+		}
+		m_condition.notify_one();
+		if (m_dumper.joinable()) m_dumper.join();
+		if (file == nullptr) return;
+		m_file = file;
+		m_dumper = std::thread([this, file, interval, json]() {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (!m_condition.wait_for(lock, std::chrono::milliseconds(interval ? interval : 1000), [this]() { return m_file == nullptr; }))
+			{
+				InstrumentationSnapshot snapshot;
+				this->snapshot(snapshot);
+				write(file, snapshot, json);
+			}
+		});
+	}
+
+	~Instrumentation()
+	{
+		periodic(nullptr, 0, false);
+	}
+
+private:
+	struct Histogram
+	{
+		std::atomic<unsigned long long> count{ 0 };
+		std::atomic<unsigned long long> total{ 0 };
+		std::atomic<unsigned long long> max{ 0 };
+		std::atomic<unsigned long long> buckets[WHISTOGRAM_BUCKETS]{};
+	};
+
+	Histogram m_calls[WCALL_COUNT];
+	std::atomic<unsigned long long> m_counters[WCOUNTER_COUNT]{};
+	std::atomic<unsigned long long> m_events[WEVENT_LIVERESIZE + 1]{};
+	std::atomic<unsigned long long> m_native[WNATIVE_TYPES]{};
+	std::atomic<unsigned long long> m_depths[WQUEUE_COUNT]{};
+
+	// serializes the starts and the stops of the dumps
+	std::mutex m_control;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	// the file of the periodic dumps, null once they stop
+	FILE* m_file = nullptr;
+	std::thread m_dumper;
+
+	static void raise(std::atomic<unsigned long long>& maximum, unsigned long long value) noexcept
+	{
+		unsigned long long current = maximum.load(std::memory_order_relaxed);
+		while (current < value && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+	}
+};
+
+/**
+ * time a call from its construction to its destruction
+ */
+struct InstrumentedCall
+{
+	explicit InstrumentedCall(unsigned int call) noexcept
+		: m_call(call)
+		, m_start(std::chrono::steady_clock::now())
+	{
+	}
+
+	~InstrumentedCall() noexcept
+	{
+		Instrumentation::get().call(m_call, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+	}
+
+private:
+	unsigned int const m_call;
+	std::chrono::steady_clock::time_point const m_start;
+};
+
+#ifdef WINDOWINPUT_INSTRUMENT
+#define WINSTRUMENT_CALL(call) InstrumentedCall const instrumented_call(call)
+#define WINSTRUMENT_COUNT(counter) Instrumentation::get().count(counter)
+#define WINSTRUMENT_EVENT(type) Instrumentation::get().event(type)
+#define WINSTRUMENT_NATIVE(type) Instrumentation::get().native(type)
+#define WINSTRUMENT_DEPTH(queue, size) Instrumentation::get().depth(queue, size)
+#else
+#define WINSTRUMENT_CALL(call) ((void)0)
+#define WINSTRUMENT_COUNT(counter) ((void)0)
+#define WINSTRUMENT_EVENT(type) ((void)0)
+#define WINSTRUMENT_NATIVE(type) ((void)0)
+#define WINSTRUMENT_DEPTH(queue, size) ((void)0)
+#endif
+
+#endif // !__INSTRUMENTATION_HPP
@@ -0,0 +1,51 @@
+#ifndef __KEYSTATE_HPP
+#define __KEYSTATE_HPP 1
+
+#include <atomic>
+
+/**
+ * Pressed Key Table
+ * a bit per key code of the backend, one cache line, written by the event thread of the window,
+ * read by any thread without a lock or a server round trip
+ */
+struct alignas(64) KeyState
+{
+	/**
+	 * @param key[in] the key code of the backend
+	 * @param down[in] whether the key is pressed
+	 * @return whether the state of the key has changed
+	 */
+	bool set(unsigned char key, bool down) noexcept
+	{
+		unsigned long long const bit = 1ull << (key & 63);
+		unsigned long long const previous = down
+			? m_bits[key >> 6].fetch_or(bit, std::memory_order_relaxed)
+			: m_bits[key >> 6].fetch_and(~bit, std::memory_order_relaxed);
+		return ((previous & bit) != 0) != down;
+	}
+
+	/**
+	 * @param key[in] the key code of the backend
+	 * @return whether the key is pressed
+	 */
+	bool test(unsigned char key) const noexcept
+	{
+		return (m_bits[key >> 6].load(std::memory_order_relaxed) >> (key & 63)) & 1;
+	}
+
+	/**
+	 * release every key, the releases are not reported to a window without the focus
+	 */
+	void clear() noexcept
+	{
+		for (std::atomic<unsigned long long>& bits : m_bits)
+		{
+			bits.store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	std::atomic<unsigned long long> m_bits[4]{};
+};
+
+#endif // !__KEYSTATE_HPP
@@ -0,0 +1,77 @@
+#ifndef __LIVERESIZE_HPP
+#define __LIVERESIZE_HPP 1
+
+#include "Event.hpp"
+#include <atomic>
+
+/**
+ * Live Resize State of a Window
+ * while the user drags the frame of the window the size changes reach the listeners at most once per interval,
+ * a change held back is delivered by the next change past the interval or by the end of the live resize,
+ * accessed by the event thread of the window only except live()
+ */
+struct LiveResize
+{
+	bool live() const noexcept
+	{
+		return m_live.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @return whether a live resize has begun
+	 */
+	bool begin() noexcept
+	{
+		if (m_live.exchange(true, std::memory_order_relaxed)) return false;
+		m_last = 0;
+		m_held = false;
+		return true;
+	}
+
+	/**
+	 * @param held[out] whether a size change is still held back and has to be delivered
+	 * @return whether a live resize has ended
+	 */
+	bool end(bool& held) noexcept
+	{
+		held = release();
+		return m_live.exchange(false, std::memory_order_relaxed);
+	}
+
+	/**
+	 * called for every size change
+	 * @param interval[in] the minimum time between two delivered changes in microseconds
+	 * @return whether the change has to be held back
+	 */
+	bool hold(unsigned long long interval) noexcept
+	{
+		if (!live()) return false;
+		unsigned long long const now = Event::now();
+		if (m_last && now - m_last < interval)
+		{
+			m_held = true;
+			return true;
+		}
+		m_last = now;
+		m_held = false;
+		return false;
+	}
+
+	/**
+	 * @return whether a size change is held back and has to be delivered now
+	 */
+	bool release() noexcept
+	{
+		if (!m_held) return false;
+		m_held = false;
+		m_last = Event::now();
+		return true;
+	}
+
+private:
+	std::atomic<bool> m_live{ false };
+	unsigned long long m_last = 0;
+	bool m_held = false;
+};
+
+#endif // !__LIVERESIZE_HPP
@@ -0,0 +1,103 @@
+#ifndef __POINTERHISTORY_HPP
+#define __POINTERHISTORY_HPP 1
+
+#include "Event.hpp"
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+/**
+ * Pointer Motion History of a Window
+ * a ring of the latest samples, the producer overwrites the oldest ones and never waits,
+ * every cell is a sequence lock so a reader skips the cells overwritten while it copies them,
+ * the ring is allocated by the first read, so the windows nobody reads record nothing
+ */
+struct PointerHistory
+{
+	static constexpr size_t Capacity = 1024;
+
+	~PointerHistory()
+	{
+		delete m_ring.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * called by the event thread of the window only
+	 */
+	void record(short x, short y, unsigned long long time) noexcept
+	{
+		Ring* ring = m_ring.load(std::memory_order_acquire);
+		if (ring == nullptr) return;
+		size_t const position = ring->tail.load(std::memory_order_relaxed);
+		Cell& cell = ring->cells[position & (Capacity - 1)];
+		cell.sequence.store(2 * position + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		cell.point.store(static_cast<unsigned short>(x) | static_cast<unsigned int>(static_cast<unsigned short>(y)) << 16, std::memory_order_relaxed);
+		cell.time.store(time, std::memory_order_relaxed);
+		cell.sequence.store(2 * position + 2, std::memory_order_release);
+		ring->tail.store(position + 1, std::memory_order_release);
+	}
+
+	/**
+	 * pull the samples recorded since the previous read, the oldest first
+	 * @param samples[out] the samples
+	 * @param capacity[in] the maximum number of the samples to pull
+	 * @return the number of the pulled samples
+	 */
+	size_t read(PointerSample* samples, size_t capacity) noexcept
+	{
+		Ring* ring = m_ring.load(std::memory_order_acquire);
+		if (ring == nullptr)
+		{
+			Ring* created = new (std::nothrow) Ring();
+			if (created == nullptr) return 0;
+			if (m_ring.compare_exchange_strong(ring, created, std::memory_order_acq_rel))
+			{
+				return 0;
+			}
+			delete created;
+		}
+
+		size_t count;
+		size_t head = ring->head.load(std::memory_order_relaxed);
+		size_t end;
+		do
+		{
+			size_t const tail = ring->tail.load(std::memory_order_acquire);
+			// the samples older than the ring have been overwritten
+			size_t const start = tail > head + Capacity ? tail - Capacity : head;
+			end = tail - start > capacity ? start + capacity : tail;
+			count = 0;
+			for (size_t position = start; position < end; ++position)
+			{
+				Cell const& cell = ring->cells[position & (Capacity - 1)];
+				size_t const sequence = cell.sequence.load(std::memory_order_acquire);
+				unsigned int const point = cell.point.load(std::memory_order_relaxed);
+				unsigned long long const time = cell.time.load(std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (sequence != 2 * position + 2 || cell.sequence.load(std::memory_order_relaxed) != sequence) continue;
+				samples[count++] = PointerSample{ static_cast<short>(point & 0xffff), static_cast<short>(point >> 16), time };
+			}
+		} while (!ring->head.compare_exchange_weak(head, end, std::memory_order_relaxed));
+		return count;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence{ 0 };
+		std::atomic<unsigned int> point{ 0 };
+		std::atomic<unsigned long long> time{ 0 };
+	};
+
+	struct Ring
+	{
+		Cell cells[Capacity];
+		alignas(64) std::atomic<size_t> head{ 0 };
+		alignas(64) std::atomic<size_t> tail{ 0 };
+	};
+
+	std::atomic<Ring*> m_ring{ nullptr };
+};
+
+#endif // !__POINTERHISTORY_HPP
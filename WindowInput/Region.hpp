@@ -0,0 +1,178 @@
+#ifndef __REGION_HPP
+#define __REGION_HPP 1
+
+#include "Window.hpp"
+#include <climits>
+#include <cstring>
+#include <mutex>
+
+/**
+ * Coalesced Rectangle List
+ * a rectangle touching another one is merged into their bounding box,
+ * a full list merges a new rectangle into the one growing the least
+ */
+struct Region
+{
+	static constexpr size_t Capacity = 16;
+
+	/**
+	 * add a rectangle clipped to a size
+	 */
+	void add(short x, short y, short width, short height, short clipWidth, short clipHeight) noexcept
+	{
+		int left = x < 0 ? 0 : x, top = y < 0 ? 0 : y;
+		int right = x + width > clipWidth ? clipWidth : x + width;
+		int bottom = y + height > clipHeight ? clipHeight : y + height;
+		if (left >= right || top >= bottom) return;
+		Box box{ left, top, right, bottom };
+
+		// a merged rectangle may touch the ones it did not before
+		for (size_t i = 0; i < m_count;)
+		{
+			Box other = Box::of(m_rects[i]);
+			if (box.touches(other))
+			{
+				box = box.unite(other);
+				m_rects[i] = m_rects[--m_count];
+				i = 0;
+				continue;
+			}
+			++i;
+		}
+		if (m_count == Capacity)
+		{
+			size_t best = 0;
+			long long growth = -1;
+			for (size_t i = 0; i < m_count; ++i)
+			{
+				Box other = Box::of(m_rects[i]);
+				long long const cost = box.unite(other).area() - other.area();
+				if (growth < 0 || cost < growth)
+				{
+					best = i;
+					growth = cost;
+				}
+			}
+			box = box.unite(Box::of(m_rects[best]));
+			m_rects[best] = m_rects[--m_count];
+		}
+		m_rects[m_count++] = box.rect();
+	}
+
+	bool empty() const noexcept { return m_count == 0; }
+
+	size_t size() const noexcept { return m_count; }
+
+	WindowRect const* begin() const noexcept { return m_rects; }
+
+	WindowRect const* end() const noexcept { return m_rects + m_count; }
+
+	void clear() noexcept { m_count = 0; }
+
+	/**
+	 * @return the bounding box of the rectangles
+	 */
+	WindowRect bounds() const noexcept
+	{
+		if (m_count == 0) return WindowRect{ 0, 0, 0, 0 };
+		Box box = Box::of(m_rects[0]);
+		for (WindowRect const& rect : *this)
+		{
+			box = box.unite(Box::of(rect));
+		}
+		return box.rect();
+	}
+
+	/**
+	 * copy the pixels of the rectangles from a buffer into another one
+	 */
+	void copy(unsigned int const* from, unsigned int* to, int pitch) const noexcept
+	{
+		for (WindowRect const& rect : *this)
+		{
+			for (int y = rect.y; y < rect.y + rect.height; ++y)
+			{
+				std::memcpy(to + y * pitch + rect.x, from + y * pitch + rect.x, rect.width * sizeof(unsigned int));
+			}
+		}
+	}
+
+private:
+	struct Box
+	{
+		int left;
+		int top;
+		int right;
+		int bottom;
+
+		static Box of(WindowRect const& rect) noexcept
+		{
+			return Box{ rect.x, rect.y, rect.x + rect.width, rect.y + rect.height };
+		}
+
+		bool touches(Box const& other) const noexcept
+		{
+			return left <= other.right && other.left <= right && top <= other.bottom && other.top <= bottom;
+		}
+
+		Box unite(Box const& other) const noexcept
+		{
+			return Box{ left < other.left ? left : other.left, top < other.top ? top : other.top,
+				right > other.right ? right : other.right, bottom > other.bottom ? bottom : other.bottom };
+		}
+
+		long long area() const noexcept
+		{
+			return static_cast<long long>(right - left) * (bottom - top);
+		}
+
+		WindowRect rect() const noexcept
+		{
+			return WindowRect{ static_cast<short>(left), static_cast<short>(top), static_cast<short>(right - left), static_cast<short>(bottom - top) };
+		}
+	};
+
+	WindowRect m_rects[Capacity];
+	size_t m_count = 0;
+};
+
+/**
+ * Damage Region of a Window
+ * the regions the system asks to repaint, added by the event thread of the window, taken by any thread
+ */
+struct WindowDamage
+{
+	void add(short x, short y, short width, short height) noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_region.add(x, y, width, height, SHRT_MAX, SHRT_MAX);
+	}
+
+	/**
+	 * take the rectangles and clear the region,
+	 * a capacity smaller than the number of the rectangles gets their bounding box
+	 */
+	size_t take(WindowRect* rects, size_t capacity) noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (capacity == 0 || m_region.empty()) return 0;
+		size_t count = m_region.size();
+		if (count > capacity)
+		{
+			rects[0] = m_region.bounds();
+			count = 1;
+		}
+		else
+		{
+			std::memcpy(rects, m_region.begin(), count * sizeof(WindowRect));
+		}
+		m_region.clear();
+		return count;
+	}
+
+private:
+	std::mutex m_mutex;
+	Region m_region;
+};
+
+#endif // !__REGION_HPP
@@ -0,0 +1,85 @@
+#ifndef __SURFACE_HPP
+#define __SURFACE_HPP 1
+
+#include "Region.hpp"
+
+/**
+ * Double Buffered Surface
+ * the buffer swapping and the damage tracking shared by the backends,
+ * a backend provides the two buffers and pushes the damaged regions of one
+ */
+struct Surface : ISurface
+{
+	Surface(short width, short height) noexcept
+		: m_width(width)
+		, m_height(height)
+		, m_pitch(width)
+	{
+	}
+
+	unsigned int* getPixels() const noexcept override
+	{
+		return m_buffers[m_back];
+	}
+
+	int getPitch() const noexcept override
+	{
+		return m_pitch;
+	}
+
+	void getSize(short& width, short& height) const noexcept override
+	{
+		width = m_width;
+		height = m_height;
+	}
+
+	void damage(short x, short y, short width, short height) noexcept override
+	{
+		m_damage.add(x, y, width, height, m_width, m_height);
+	}
+
+	void present() noexcept override
+	{
+		if (m_buffers[m_back] == nullptr) return;
+		if (m_damage.empty())
+		{
+			m_damage.add(0, 0, m_width, m_height, m_width, m_height);
+		}
+		unsigned int front = m_back;
+		push(front, m_damage);
+		m_back ^= 1;
+		// the pixels presented last are the starting point of the next frame
+		if (!wait(m_back))
+		{
+			// the backend may still read the buffer, the next present pushes all of it instead of its copied damage
+			m_damage.clear();
+			m_damage.add(0, 0, m_width, m_height, m_width, m_height);
+			return;
+		}
+		m_damage.copy(m_buffers[front], m_buffers[m_back], m_pitch);
+		m_damage.clear();
+	}
+
+protected:
+	short const m_width;
+	short const m_height;
+	int m_pitch;
+	unsigned int* m_buffers[2]{ nullptr, nullptr };
+	unsigned int m_back = 0;
+
+	/**
+	 * push the damaged regions of a buffer into the client area
+	 */
+	virtual void push(unsigned int buffer, Region const& damage) noexcept = 0;
+
+	/**
+	 * wait until the backend does not read a buffer anymore
+	 * @return false if the backend may still read it
+	 */
+	virtual bool wait(unsigned int buffer) noexcept { return true; }
+
+private:
+	Region m_damage;
+};
+
+#endif // !__SURFACE_HPP
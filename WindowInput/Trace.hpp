@@ -0,0 +1,257 @@
+#ifndef __TRACE_HPP
+#define __TRACE_HPP 1
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * start or stop recording the spans of the event pipeline, stopped by default,
+ * a thread allocates its buffer at its first span
+ *
+ * @param enabled[in] whether to record
+ */
+void setTracing(bool enabled) noexcept;
+
+/**
+ * write the spans recorded so far as a Chrome trace, a JSON object chrome://tracing and Perfetto open,
+ * the oldest spans of a thread are overwritten once its buffer is full
+ *
+ * @param file[in] the file to write to
+ * @return whether the trace was written
+ */
+bool exportTrace(FILE* file);
+
+/**
+ * Trace Buffer of a Thread
+ * a ring of spans written by its thread only and read by the exports without a lock,
+ * a span being written or overwritten while an export copies it is left out of the export
+ */
+struct TraceBuffer
+{
+	static constexpr size_t Capacity = 8192;
+
+	struct Span
+	{
+		// odd while the span at a position is written, even once it is complete, 2 * (position + 1) then
+		std::atomic<size_t> sequence;
+		// a string literal naming the stage
+		std::atomic<char const*> name;
+		// the nanoseconds of the steady clock, an instant has no duration
+		std::atomic<unsigned long long> begin;
+		std::atomic<unsigned long long> end;
+		// the native event type or message of the stage
+		std::atomic<unsigned long long> arg;
+	};
+
+	TraceBuffer(unsigned int id, char const* name) noexcept
+		: m_id(id)
+		, m_name(name)
+	{
+	}
+
+	void record(char const* name, unsigned long long begin, unsigned long long end, unsigned long long arg) noexcept
+	{
+		size_t const position = m_written.load(std::memory_order_relaxed);
+		Span& span = m_spans[position % Capacity];
+		span.sequence.store(2 * position + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		span.name.store(name, std::memory_order_relaxed);
+		span.begin.store(begin, std::memory_order_relaxed);
+		span.end.store(end, std::memory_order_relaxed);
+		span.arg.store(arg, std::memory_order_relaxed);
+		span.sequence.store(2 * position + 2, std::memory_order_release);
+		m_written.store(position + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @param write[in] called with the name, the times and the argument of every span still in the ring, the oldest first
+	 */
+	template<typename Write>
+	void read(Write&& write) const
+	{
+		size_t const written = m_written.load(std::memory_order_acquire);
+		size_t const first = written > Capacity ? written - Capacity : 0;
+		for (size_t position = first; position < written; ++position)
+		{
+			Span const& span = m_spans[position % Capacity];
+			size_t const sequence = span.sequence.load(std::memory_order_acquire);
+			if (sequence != 2 * position + 2) continue;
+			char const* const name = span.name.load(std::memory_order_relaxed);
+			unsigned long long const begin = span.begin.load(std::memory_order_relaxed);
+			unsigned long long const end = span.end.load(std::memory_order_relaxed);
+			unsigned long long const arg = span.arg.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			// the writer went round the ring and began the span of a later position meanwhile
+			if (span.sequence.load(std::memory_order_relaxed) != sequence) continue;
+			write(name, begin, end, arg);
+		}
+	}
+
+	unsigned int id() const noexcept
+	{
+		return m_id;
+	}
+
+	char const* name() const noexcept
+	{
+		return m_name;
+	}
+
+private:
+	unsigned int const m_id;
+	char const* const m_name;
+	std::atomic<size_t> m_written{ 0 };
+	Span m_spans[Capacity]{};
+};
+
+/**
+ * Event Pipeline Tracer
+ * the buffers of the threads stay registered after the threads end, so their spans are still exported
+ */
+struct Trace
+{
+	static Trace& get() noexcept
+	{
+		// never destroyed, the threads ending after the exit still record into their buffers
+		static Trace* const instance = new Trace();
+		return *instance;
+	}
+
+	static bool enabled() noexcept
+	{
+		return get().m_enabled.load(std::memory_order_relaxed);
+	}
+
+	static unsigned long long now() noexcept
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	 * name the calling thread in the exports, before its first span
+	 * @param name[in] a string literal
+	 */
+	static void name(char const* name) noexcept
+	{
+		threadName() = name;
+	}
+
+	/**
+	 * record a span of the calling thread
+	 */
+	static void record(char const* name, unsigned long long begin, unsigned long long end, unsigned long long arg) noexcept
+	{
+		TraceBuffer*& buffer = threadBuffer();
+		if (buffer == nullptr && (buffer = get().add()) == nullptr) return;
+		buffer->record(name, begin, end, arg);
+	}
+
+	/**
+	 * @see setTracing
+	 */
+	void enable(bool enabled) noexcept
+	{
+		m_enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @see exportTrace
+	 */
+	bool write(FILE* file)
+	{
+		if (file == nullptr) return false;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		bool first = true;
+		std::fputs("{\"traceEvents\":[", file);
+		for (std::unique_ptr<TraceBuffer> const& buffer : m_buffers)
+		{
+			unsigned int const tid = buffer->id();
+			std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+				first ? "" : ",", tid, buffer->name() ? buffer->name() : "thread");
+			first = false;
+			buffer->read([file, tid](char const* name, unsigned long long begin, unsigned long long end, unsigned long long arg) {
+				// the times are in microseconds, with the nanoseconds as the decimals
+				if (begin == end)
+				{
+					std::fprintf(file, ",{\"name\":\"%s\",\"cat\":\"windowinput\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu.%03llu,\"pid\":1,\"tid\":%u,\"args\":{\"arg\":%llu}}",
+						name, begin / 1000, begin % 1000, tid, arg);
+				}
+				else
+				{
+					unsigned long long const duration = end - begin;
+					std::fprintf(file, ",{\"name\":\"%s\",\"cat\":\"windowinput\",\"ph\":\"X\",\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,\"pid\":1,\"tid\":%u,\"args\":{\"arg\":%llu}}",
+						name, begin / 1000, begin % 1000, duration / 1000, duration % 1000, tid, arg);
+				}
+			});
+		}
+		std::fputs("],\"displayTimeUnit\":\"ns\"}\n", file);
+		return std::fflush(file) == 0;
+	}
+
+private:
+	std::atomic<bool> m_enabled{ false };
+	std::mutex m_mutex;
+	std::vector<std::unique_ptr<TraceBuffer>> m_buffers;
+
+	static char const*& threadName() noexcept
+	{
+		static thread_local char const* name = nullptr;
+		return name;
+	}
+
+	static TraceBuffer*& threadBuffer() noexcept
+	{
+		static thread_local TraceBuffer* buffer = nullptr;
+		return buffer;
+	}
+
+	TraceBuffer* add() noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		TraceBuffer* buffer = new (std::nothrow) TraceBuffer(static_cast<unsigned int>(m_buffers.size() + 1), threadName());
+		if (buffer == nullptr) return nullptr;
+		m_buffers.emplace_back(buffer);
+		return buffer;
+	}
+};
+
+/**
+ * record a span from its construction to its destruction, nothing while the tracing is stopped
+ */
+struct TraceSpan
+{
+	explicit TraceSpan(char const* name, unsigned long long arg = 0) noexcept
+		: m_name(name)
+		, m_arg(arg)
+		, m_begin(Trace::enabled() ? Trace::now() : 0)
+	{
+	}
+
+	~TraceSpan() noexcept
+	{
+		if (m_begin) Trace::record(m_name, m_begin, Trace::now(), m_arg);
+	}
+
+private:
+	char const* const m_name;
+	unsigned long long const m_arg;
+	unsigned long long const m_begin;
+};
+
+#define WTRACE_CONCAT_(a, b) a##b
+#define WTRACE_CONCAT(a, b) WTRACE_CONCAT_(a, b)
+/**
+ * trace the rest of the scope
+ */
+#define WTRACE_SPAN(name, arg) TraceSpan const WTRACE_CONCAT(trace_span, __LINE__)(name, arg)
+/**
+ * trace a point in time
+ */
+#define WTRACE_INSTANT(name, arg) do { if (Trace::enabled()) { unsigned long long const trace_now = Trace::now(); Trace::record(name, trace_now, trace_now, arg); } } while (0)
+
+#endif // !__TRACE_HPP
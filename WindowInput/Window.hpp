@@ -2,8 +2,12 @@
 #define __WINDOW_HPP 1
 
 #include "../common.h"
+#include "Event.hpp"
+#include <future>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <vector>
 
 #define WSTYLE_DEFAULT 0x0000
 #define WSTYLE_NOBORDER 0x0001
@@ -24,6 +28,161 @@ using Window = struct IWindow const&;
  */
 using PWindow = std::shared_ptr<struct IWindow const>;
 
+/**
+ * Window Specification
+ * the arguments of a window creation, @see IWindow::createMany
+ */
+struct WindowSpec
+{
+	// the window title in ASCII, null to use the Unicode title
+	char const* title = nullptr;
+	// the window title in Unicode, null for a window without a title
+	wchar_t const* unicode = nullptr;
+	// the window style @see WSTYLE_DEFAULT, WSTYLE_*
+	int style = WSTYLE_DEFAULT;
+	short width = 640;
+	short height = 480;
+};
+
+/**
+ * Rectangle of a Client Area
+ */
+struct WindowRect
+{
+	short x;
+	short y;
+	short width;
+	short height;
+};
+
+/**
+ * Framebuffer Surface of a Window
+ * a CPU framebuffer of 32-bit 0x00RRGGBB pixels, double buffered:
+ * the caller draws into the back buffer while the backend still shows the front buffer
+ */
+struct ISurface
+{
+	virtual ~ISurface() {}
+
+	/**
+	 * @return the back buffer, keeping the pixels presented last
+	 */
+	virtual unsigned int* getPixels() const noexcept = 0;
+
+	/**
+	 * @return the number of the pixels from a row to the next one
+	 */
+	virtual int getPitch() const noexcept = 0;
+
+	virtual void getSize(short& width, short& height) const noexcept = 0;
+
+	/**
+	 * mark a changed region of the back buffer, a present without damage pushes the whole surface
+	 */
+	virtual void damage(short x, short y, short width, short height) noexcept = 0;
+
+	/**
+	 * push the damaged regions into the client area and swap the buffers
+	 */
+	virtual void present() noexcept = 0;
+};
+/**
+ * Surface Ptr
+ */
+using PSurface = std::shared_ptr<ISurface>;
+
+/**
+ * Frame Statistics of a Window
+ * the times are in microseconds of the steady clock @see Event::now
+ */
+struct FrameStats
+{
+	// the number of the delivered frames
+	unsigned long long frames;
+	// the number of the frames skipped while the window was hidden or minimized
+	unsigned long long skipped;
+	// the number of the frames skipped while the surface of the window was still presenting the previous one
+	unsigned long long missed;
+	// the time of the last delivered frame
+	unsigned long long time;
+	// the time between the last two delivered frames, 0 for the first frame after a pause
+	unsigned int interval;
+	// the moving average and the maximum of the intervals
+	unsigned int average;
+	unsigned int worst;
+};
+
+/**
+ * Window Listener
+ * the handlers are called by the thread dispatching the events of a window
+ */
+struct IWindowListener
+{
+	virtual ~IWindowListener() {}
+
+	/**
+	 * @param window[in] the resized window
+	 * @param width[in] the new width of the client area
+	 * @param height[in] the new height of the client area
+	 */
+	virtual void onResize(Window window, short width, short height) {}
+
+	/**
+	 * the user drags the frame of a window, the resizes in between are throttled to the frame rate
+	 * and the last one comes before the end @see IWindow::isLiveResizing
+	 *
+	 * @param window[in] the window being resized
+	 * @param active[in] whether the live resize has begun or ended
+	 */
+	virtual void onLiveResize(Window window, bool active) {}
+
+	/**
+	 * @param window[in] the window gaining or losing the focus
+	 * @param active[in] whether the window has got the focus
+	 */
+	virtual void onFocus(Window window, bool active) {}
+
+	/**
+	 * @param window[in] the window under the pointer
+	 * @param x[in] the x-coordinate of the client area cursor position
+	 * @param y[in] the y-coordinate of the client area cursor position
+	 */
+	virtual void onPointerMove(Window window, short x, short y) {}
+
+	/**
+	 * @param window[in] the window having the focus
+	 * @param key[in] the key code of the backend
+	 * @param down[in] whether the key has been pressed, a held key repeats it
+	 */
+	virtual void onKey(Window window, short key, bool down) {}
+
+	/**
+	 * @param window[in] the window having the focus
+	 * @param codepoint[in] the UTF-32 code point of the typed character
+	 */
+	virtual void onText(Window window, char32_t codepoint) {}
+
+	/**
+	 * the time to render a frame, once per display refresh while the frames are requested
+	 * and the window is mapped and not minimized @see IWindow::requestFrames,
+	 * called on the event thread of the window like every handler, the dispatcher or an event worker on X,
+	 * so it must not block waiting for display events, a frame is missed while a present is still pending
+	 *
+	 * @param window[in] the window to render
+	 * @param stats[in] the statistics including this frame
+	 */
+	virtual void onFrame(Window window, FrameStats const& stats) {}
+
+	/**
+	 * @param window[in] the window being closed, the last event of a window
+	 */
+	virtual void onClose(Window window) {}
+};
+/**
+ * Window Listener Ptr
+ */
+using PWindowListener = std::shared_ptr<IWindowListener>;
+
 /**
  * Window Interface
  */
@@ -91,6 +250,58 @@ struct IWindow
 	 */
 	virtual PWindow create(int style = WSTYLE_DEFAULT, short width = 640, short height = 480) const = 0;
 
+	/**
+	 * create a child window of a window without waiting for the native window
+	 *
+	 * @param title[in] the window title in ASCII
+	 * @param style[in] the window style @see WSTYLE_DEFAULT, WSTYLE_*
+	 * @param width[in] the window width
+	 * @param height[in] the window height
+	 * @return a future completed with a pointer of the created window once the native window exists
+	 */
+	virtual std::future<PWindow> createAsync(std::string title, int style = WSTYLE_DEFAULT, short width = 640, short height = 480) const = 0;
+
+	/**
+	 * create a child window of a window without waiting for the native window
+	 *
+	 * @param title[in] the window title in Unicode
+	 * @param style[in] the window style @see WSTYLE_DEFAULT, WSTYLE_*
+	 * @param width[in] the window width
+	 * @param height[in] the window height
+	 * @return a future completed with a pointer of the created window once the native window exists
+	 */
+	virtual std::future<PWindow> createAsync(std::wstring title, int style = WSTYLE_DEFAULT, short width = 640, short height = 480) const = 0;
+
+	/**
+	 * create a child window of a window without waiting for the native window
+	 *
+	 * @param style[in] the window style @see WSTYLE_DEFAULT, WSTYLE_*
+	 * @param width[in] the window width
+	 * @param height[in] the window height
+	 * @return a future completed with a pointer of the created window once the native window exists
+	 */
+	virtual std::future<PWindow> createAsync(int style = WSTYLE_DEFAULT, short width = 640, short height = 480) const = 0;
+
+	/**
+	 * create child windows of a window at once, the backend sends the requests in one batch
+	 *
+	 * @param specs[in] the specifications of the windows
+	 * @param count[in] the number of the windows
+	 * @return the pointers of the created windows in the order of the specifications
+	 */
+	virtual std::vector<PWindow> createMany(WindowSpec const* specs, size_t count) const = 0;
+
+	/**
+	 * create child windows of a window at once, the backend sends the requests in one batch
+	 *
+	 * @param specs[in] the specifications of the windows
+	 * @return the pointers of the created windows in the order of the specifications
+	 */
+	std::vector<PWindow> createMany(std::vector<WindowSpec> const& specs) const
+	{
+		return createMany(specs.data(), specs.size());
+	}
+
 	virtual void show() const noexcept = 0;
 
 	virtual void minimize() const noexcept = 0;
@@ -139,6 +350,26 @@ struct IWindow
 	 */
 	virtual Title getTitle() const noexcept = 0;
 
+	/**
+	 * copy the title of a window, in UTF-8, from the cache of the backend,
+	 * without a round trip or an allocation
+	 *
+	 * @param buffer[out] the title, null-terminated, a truncated title does not end in the middle of a character
+	 * @param capacity[in] the size of the buffer in bytes
+	 * @return the length of the title in bytes, not less than the capacity if the title was truncated
+	 */
+	virtual size_t getTitle(char* buffer, size_t capacity) const noexcept = 0;
+
+	/**
+	 * @param buffer[out] the title in UTF-8, null-terminated
+	 * @return the length of the title in bytes, not less than the capacity if the title was truncated
+	 */
+	template<size_t Capacity>
+	size_t getTitle(char (&buffer)[Capacity]) const noexcept
+	{
+		return getTitle(buffer, Capacity);
+	}
+
 	/**
 	 * @param title[in] the new title, in ASCII, of a window
 	 */
@@ -160,10 +391,188 @@ struct IWindow
 	void setTitle(std::wstring const& title) const noexcept { setTitle(title.c_str()); }
 
 	/**
+	 * a lookup of the window tree the library keeps, without a round trip
 	 * @return a pointer to the parent of a window
 	 */
 	virtual PWindow getParent() const = 0;
 
+	/**
+	 * a lookup of the window tree the library keeps, without a round trip,
+	 * the children of a root window are its top-level windows
+	 *
+	 * @param children[out] the open children of a window, the earliest created first
+	 * @param capacity[in] the maximum number of the children to get
+	 * @return the number of the children, greater than the capacity if some did not fit
+	 */
+	virtual size_t getChildren(PWindow* children, size_t capacity) const = 0;
+
+	/**
+	 * @param children[out] the open children of a window, the earliest created first
+	 * @return the number of the children, greater than the capacity if some did not fit
+	 */
+	template<size_t Capacity>
+	size_t getChildren(PWindow (&children)[Capacity]) const
+	{
+		return getChildren(children, Capacity);
+	}
+
+	/**
+	 * pull the pointer positions recorded since the previous call, the motion the events coalesced included,
+	 * the window starts recording at the first call and keeps the latest samples only
+	 *
+	 * @param samples[out] the samples, the oldest first
+	 * @param capacity[in] the maximum number of the samples to pull
+	 * @return the number of the pulled samples
+	 */
+	virtual size_t getPointerHistory(PointerSample* samples, size_t capacity) const noexcept = 0;
+
+	/**
+	 * pull the pointer positions recorded since the previous call
+	 *
+	 * @param samples[out] the samples, the oldest first
+	 * @return the number of the pulled samples
+	 */
+	template<size_t Capacity>
+	size_t getPointerHistory(PointerSample (&samples)[Capacity]) const noexcept
+	{
+		return getPointerHistory(samples, Capacity);
+	}
+
+	/**
+	 * a lookup of the key table of the window, without a round trip,
+	 * a window losing the focus releases its keys
+	 *
+	 * @param key[in] the key code of the backend
+	 * @return whether the key is pressed
+	 */
+	virtual bool isKeyDown(unsigned char key) const noexcept = 0;
+
+	/**
+	 * @return whether the user is dragging the frame of a window
+	 */
+	virtual bool isLiveResizing() const noexcept = 0;
+
+	/**
+	 * take the parts of the client area to repaint, exposed since the previous call,
+	 * coalesced into a few rectangles
+	 *
+	 * @param rects[out] the rectangles to repaint
+	 * @param capacity[in] the maximum number of the rectangles, a smaller capacity than needed gets their bounding box
+	 * @return the number of the rectangles
+	 */
+	virtual size_t takeDamage(WindowRect* rects, size_t capacity) const noexcept = 0;
+
+	/**
+	 * take the parts of the client area to repaint, exposed since the previous call
+	 *
+	 * @param rects[out] the rectangles to repaint
+	 * @return the number of the rectangles
+	 */
+	template<size_t Capacity>
+	size_t takeDamage(WindowRect (&rects)[Capacity]) const noexcept
+	{
+		return takeDamage(rects, Capacity);
+	}
+
+	/**
+	 * start or stop the frame callbacks of a window @see IWindowListener::onFrame,
+	 * a frame the listeners are still rendering when the next one is due makes the next one dropped
+	 *
+	 * @param enabled[in] whether to deliver the frames
+	 */
+	virtual void requestFrames(bool enabled) const = 0;
+
+	/**
+	 * @return the frame statistics of a window
+	 */
+	virtual FrameStats getFrameStats() const noexcept = 0;
+
+	/**
+	 * map a framebuffer into the client area, at its top left corner
+	 *
+	 * @return a pointer to the surface, null if the window or the display has no 32-bit surface
+	 */
+	virtual PSurface createSurface(short width, short height) const = 0;
+
+	/**
+	 * pull the queued input events of a window in one batch,
+	 * the window starts queuing its events at the first call
+	 *
+	 * @param events[out] the events in the order the backend received them
+	 * @param capacity[in] the maximum number of the events to pull
+	 * @return the number of the pulled events
+	 */
+	virtual size_t drainEvents(Event* events, size_t capacity) const noexcept = 0;
+
+	/**
+	 * pull the queued input events of a window in one batch
+	 *
+	 * @param events[out] the events in the order the backend received them
+	 * @return the number of the pulled events
+	 */
+	template<size_t Capacity>
+	size_t drainEvents(Event (&events)[Capacity]) const noexcept
+	{
+		return drainEvents(events, Capacity);
+	}
+
+	/**
+	 * send the requests queued by the calls on the windows of the display now,
+	 * the backends without a request buffer have nothing to send
+	 */
+	virtual void flush() const noexcept = 0;
+
+	/**
+	 * Request Batch
+	 * while a batch of a display is open the calls on its windows queue their requests without sending them,
+	 * the last batch ending sends them at once @see IWindow::beginBatch
+	 */
+	struct Batch
+	{
+		Batch(Batch&& o) noexcept : m_window(o.m_window) { o.m_window = nullptr; }
+		Batch(Batch const&) = delete;
+		Batch& operator=(Batch const&) = delete;
+		~Batch() noexcept { if (m_window) m_window->endBatch(); }
+
+	private:
+		friend struct IWindow;
+		explicit Batch(IWindow const* window) noexcept : m_window(window) {}
+		IWindow const* m_window;
+	};
+
+	/**
+	 * open a batch of the requests of the display of a window, ended by the destruction of the batch,
+	 * the window has to outlive the batch and the dispatcher of the display may still send the requests earlier
+	 *
+	 * @return the batch
+	 */
+	Batch beginBatch() const noexcept
+	{
+		openBatch();
+		return Batch(this);
+	}
+
+	/**
+	 * open a batch of the requests, @see beginBatch for a batch ending by itself
+	 */
+	virtual void openBatch() const noexcept = 0;
+
+	/**
+	 * end a batch of the requests, the last batch open sends the requests
+	 */
+	virtual void endBatch() const noexcept = 0;
+
+	/**
+	 * subscribe a listener to the events of a window
+	 * @param listener[in] the listener
+	 */
+	virtual void subscribe(PWindowListener listener) const = 0;
+
+	/**
+	 * @param listener[in] the listener to unsubscribe from the events of a window
+	 */
+	virtual void unsubscribe(PWindowListener const& listener) const = 0;
+
 };
 
 /**
@@ -171,5 +580,64 @@ struct IWindow
  */
 EXTERN_C Window getRootWindow();
 
+/**
+ * a root window of another display or screen, with its own connection and event threads,
+ * the backends without several displays only have the default one
+ *
+ * @param display[in] the display name, null for the default display
+ * @param screen[in] the screen number, -1 for the default screen of the display
+ * @return a pointer to the root window, null if the display cannot be opened
+ */
+PWindow getRootWindow(char const* display, int screen);
+
+/**
+ * set the threading model of the root windows created afterwards
+ *
+ * @param threads[in] 1 for a single event thread per display (the default),
+ * N for a pool of N event threads with the windows sharded across them
+ */
+EXTERN_C void setEventThreads(unsigned int threads);
+
+/**
+ * set the frame rate of the root windows created afterwards,
+ * the backends synchronized with the display refresh use it if the display cannot tell its own
+ *
+ * @param hz[in] the frames per second, 60 by default
+ */
+EXTERN_C void setFrameRate(unsigned int hz);
+
+/**
+ * set the flushing of the root windows created afterwards,
+ * with auto flush the calls made by the listeners send their requests once the events read together are dispatched
+ * rather than one by one, the calls of the other threads still send them right away
+ *
+ * @param enabled[in] whether to flush at the end of a dispatch, disabled by default
+ */
+EXTERN_C void setAutoFlush(bool enabled);
+
+/**
+ * set the hibernation of the windows of the root windows created afterwards,
+ * a window hidden or minimized for the time leaves the frame ticks and frees the front buffer of its surface,
+ * both restored once it is shown, the backends without such resources ignore it
+ *
+ * @param ms[in] the time in milliseconds before a window hibernates, 0 to never hibernate (the default)
+ */
+EXTERN_C void setHibernation(unsigned int ms);
+
+/**
+ * set the memory the windows created afterwards are allocated from, with their titles and event rings,
+ * the resource has to outlive them
+ *
+ * @param resource[in] the memory resource, null for the default synchronized pool
+ */
+void setWindowMemory(std::pmr::memory_resource* resource);
+
+/**
+ * close the windows, join the event threads and release the root windows of every display,
+ * the windows still held stay closed and their calls do nothing, a later getRootWindow creates a new root window,
+ * no call on a window may overlap the release
+ */
+EXTERN_C void releaseRootWindow();
+
 #endif // !__WINDOW_HPP
 
@@ -0,0 +1,60 @@
+#ifndef __WINDOWLISTENERS_HPP
+#define __WINDOWLISTENERS_HPP 1
+
+#include "Trace.hpp"
+#include "Window.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/**
+ * Window Listener List
+ * copy-on-write, so notifying copies the list pointer with std::atomic_load and never waits for a subscription,
+ * the load itself may take a short internal lock, libstdc++ guards the shared_ptr atomics with a mutex pool
+ */
+struct WindowListeners
+{
+	using List = std::vector<PWindowListener>;
+
+	void add(PWindowListener listener)
+	{
+		if (listener == nullptr) return;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::shared_ptr<List const> list = std::atomic_load(&m_list);
+		std::shared_ptr<List> copy = list ? std::make_shared<List>(*list) : std::make_shared<List>();
+		copy->push_back(static_cast<PWindowListener&&>(listener));
+		std::atomic_store(&m_list, std::shared_ptr<List const>(copy));
+	}
+
+	void remove(PWindowListener const& listener)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::shared_ptr<List const> list = std::atomic_load(&m_list);
+		if (list == nullptr) return;
+		std::shared_ptr<List> copy = std::make_shared<List>(*list);
+		copy->erase(std::remove(copy->begin(), copy->end(), listener), copy->end());
+		std::atomic_store(&m_list, copy->empty() ? nullptr : std::shared_ptr<List const>(copy));
+	}
+
+	/**
+	 * @param handler[in] called with every listener, e.g. [&](IWindowListener& l) { l.onClose(window); }
+	 */
+	template<typename Handler>
+	void notify(Handler&& handler) const
+	{
+		std::shared_ptr<List const> list = std::atomic_load(&m_list);
+		if (list == nullptr) return;
+		WTRACE_SPAN("listeners", list->size());
+		for (PWindowListener const& listener : *list)
+		{
+			handler(*listener);
+		}
+	}
+
+private:
+	std::shared_ptr<List const> m_list{ nullptr };
+	std::mutex m_mutex;
+};
+
+#endif // !__WINDOWLISTENERS_HPP
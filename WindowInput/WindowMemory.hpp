@@ -0,0 +1,61 @@
+#ifndef __WINDOWMEMORY_HPP
+#define __WINDOWMEMORY_HPP 1
+
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+
+/**
+ * Window Memory
+ * the resource the windows with their control blocks, their titles and their event rings are allocated from,
+ * a synchronized pool by default, so a window created after another one was closed reuses its blocks
+ */
+inline std::pmr::memory_resource* defaultWindowMemory() noexcept
+{
+	// never destroyed, the windows released at exit still return their blocks to it
+	static std::pmr::memory_resource* const pool = new std::pmr::synchronized_pool_resource();
+	return pool;
+}
+
+inline std::atomic<std::pmr::memory_resource*>& windowMemoryResource() noexcept
+{
+	static std::atomic<std::pmr::memory_resource*> resource{ defaultWindowMemory() };
+	return resource;
+}
+
+/**
+ * @return the resource to allocate from, a block goes back to the resource it came from
+ */
+inline std::pmr::memory_resource* windowMemory() noexcept
+{
+	return windowMemoryResource().load(std::memory_order_acquire);
+}
+
+/**
+ * own a window constructed in a block of the window memory, with its control block from the same resource
+ * @param construct[in] the function constructing the window in the block, the constructors are private
+ */
+template<typename T, typename Construct>
+std::shared_ptr<T> allocateWindow(Construct&& construct)
+{
+	std::pmr::memory_resource* const resource = windowMemory();
+	void* const block = resource->allocate(sizeof(T), alignof(T));
+	T* window;
+	try
+	{
+		window = construct(block);
+	}
+	catch (...)
+	{
+		// a throwing constructor leaves no window to delete, the block goes back at once
+		resource->deallocate(block, sizeof(T), alignof(T));
+		throw;
+	}
+	// a failing allocation of the control block deletes the window
+	return std::shared_ptr<T>(window, [resource](T* window) {
+		window->~T();
+		resource->deallocate(window, sizeof(T), alignof(T));
+	}, std::pmr::polymorphic_allocator<T>(resource));
+}
+
+#endif // !__WINDOWMEMORY_HPP
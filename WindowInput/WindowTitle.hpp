@@ -0,0 +1,128 @@
+#ifndef __WINDOWTITLE_HPP
+#define __WINDOWTITLE_HPP 1
+
+#include "WindowMemory.hpp"
+#include <cstring>
+#include <string>
+
+/**
+ * append a code point to a string in UTF-8
+ */
+template<typename String>
+void appendUtf8(String& text, char32_t codepoint)
+{
+	if (codepoint < 0x80)
+	{
+		text += static_cast<char>(codepoint);
+	}
+	else if (codepoint < 0x800)
+	{
+		text += static_cast<char>(0xc0 | codepoint >> 6);
+		text += static_cast<char>(0x80 | (codepoint & 0x3f));
+	}
+	else if (codepoint < 0x10000)
+	{
+		text += static_cast<char>(0xe0 | codepoint >> 12);
+		text += static_cast<char>(0x80 | (codepoint >> 6 & 0x3f));
+		text += static_cast<char>(0x80 | (codepoint & 0x3f));
+	}
+	else
+	{
+		text += static_cast<char>(0xf0 | codepoint >> 18);
+		text += static_cast<char>(0x80 | (codepoint >> 12 & 0x3f));
+		text += static_cast<char>(0x80 | (codepoint >> 6 & 0x3f));
+		text += static_cast<char>(0x80 | (codepoint & 0x3f));
+	}
+}
+
+/**
+ * append a null-terminated wide string to a string in UTF-8,
+ * a wchar_t of 2 bytes holds UTF-16, an unpaired surrogate becomes U+FFFD
+ */
+template<typename String>
+void appendUtf8(String& text, wchar_t const* wide)
+{
+	for (; *wide; ++wide)
+	{
+		char32_t codepoint = static_cast<char32_t>(*wide);
+		if (sizeof(wchar_t) == 2 && codepoint >= 0xd800 && codepoint < 0xe000)
+		{
+			char32_t const low = static_cast<char32_t>(wide[1]);
+			if (codepoint < 0xdc00 && low >= 0xdc00 && low < 0xe000)
+			{
+				codepoint = 0x10000 + ((codepoint - 0xd800) << 10 | (low - 0xdc00));
+				++wide;
+			}
+			else
+			{
+				codepoint = 0xfffd;
+			}
+		}
+		appendUtf8(text, codepoint);
+	}
+}
+
+/**
+ * Cached Window Title
+ * the title in UTF-8, stored by the thread setting or receiving it and read by any thread
+ * without a round trip or an allocation
+ */
+struct WindowTitle
+{
+	void store(char const* text, size_t length)
+	{
+		publish(std::allocate_shared<std::pmr::string>(std::pmr::polymorphic_allocator<std::pmr::string>(windowMemory()), text, length));
+	}
+
+	/**
+	 * @param text[in] the title in UTF-8, moved without a copy if it was allocated from the window memory
+	 */
+	void store(std::pmr::string&& text)
+	{
+		publish(std::allocate_shared<std::pmr::string>(std::pmr::polymorphic_allocator<std::pmr::string>(text.get_allocator()), static_cast<std::pmr::string&&>(text)));
+	}
+
+	void store(wchar_t const* text)
+	{
+		std::shared_ptr<std::pmr::string> title = std::allocate_shared<std::pmr::string>(std::pmr::polymorphic_allocator<std::pmr::string>(windowMemory()));
+		appendUtf8(*title, text ? text : L"");
+		publish(static_cast<std::shared_ptr<std::pmr::string>&&>(title));
+	}
+
+	/**
+	 * @param buffer[out] the title, null-terminated, a truncated title does not end in the middle of a character
+	 * @param capacity[in] the size of the buffer in bytes
+	 * @return the length of the title in bytes, not less than the capacity if the title was truncated
+	 */
+	size_t copy(char* buffer, size_t capacity) const noexcept
+	{
+		std::shared_ptr<std::pmr::string const> title = std::atomic_load(&m_title);
+		size_t const length = title ? title->size() : 0;
+		if (capacity == 0) return length;
+		size_t count = length < capacity ? length : capacity - 1;
+		while (count < length && count > 0 && (static_cast<unsigned char>((*title)[count]) & 0xc0) == 0x80)
+		{
+			--count;
+		}
+		if (count) std::memcpy(buffer, title->data(), count);
+		buffer[count] = '\0';
+		return length;
+	}
+
+	std::string string() const
+	{
+		std::shared_ptr<std::pmr::string const> title = std::atomic_load(&m_title);
+		return title ? std::string(title->data(), title->size()) : std::string();
+	}
+
+private:
+	// accessed through std::atomic_load/std::atomic_store
+	std::shared_ptr<std::pmr::string const> m_title{ nullptr };
+
+	void publish(std::shared_ptr<std::pmr::string const> title) noexcept
+	{
+		std::atomic_store(&m_title, static_cast<std::shared_ptr<std::pmr::string const>&&>(title));
+	}
+};
+
+#endif // !__WINDOWTITLE_HPP
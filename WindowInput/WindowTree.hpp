@@ -0,0 +1,118 @@
+#ifndef __WINDOWTREE_HPP
+#define __WINDOWTREE_HPP 1
+
+#include "Window.hpp"
+#include <mutex>
+#include <vector>
+
+/**
+ * Window Tree
+ * the parents and the children of the windows the library has created, looked up without a server round trip,
+ * a window links its node once it is owned by a shared pointer and unlinks it before it forgets its native window,
+ * the children of a closed window are left without a parent
+ */
+struct WindowTree
+{
+	struct Node
+	{
+		std::weak_ptr<IWindow const> window;
+		Node* parent = nullptr;
+		std::vector<Node*> children;
+	};
+
+	// the node of the root window, the parent of the top-level windows
+	Node root;
+
+	/**
+	 * @param find[in] the function looking the node of the parent up, called under the lock of the tree
+	 * so a parent being closed cannot go away meanwhile, returning null for a parent the library has not created
+	 */
+	template<typename Find>
+	void link(Node& node, Find&& find, std::weak_ptr<IWindow const> window)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		node.window = static_cast<std::weak_ptr<IWindow const>&&>(window);
+		Node* parent = find();
+		if (!linked(parent)) return;
+		node.parent = parent;
+		parent->children.push_back(&node);
+	}
+
+	void unlink(Node& node) noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		remove(node);
+		node.parent = nullptr;
+		for (Node* child : node.children)
+		{
+			child->parent = nullptr;
+		}
+		node.children.clear();
+	}
+
+	/**
+	 * move a linked node under another parent, a parent the library has not created leaves it where it is
+	 * @param find[in] the function looking the node of the parent up, called under the lock of the tree
+	 */
+	template<typename Find>
+	void move(Node& node, Find&& find)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Node* parent = find();
+		if (node.parent == nullptr || node.parent == parent || !linked(parent)) return;
+		remove(node);
+		node.parent = parent;
+		parent->children.push_back(&node);
+	}
+
+	/**
+	 * @return the parent window, null for a window closed or left without a parent
+	 */
+	PWindow parent(Node const& node) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return node.parent ? PWindow(node.parent->window.lock()) : nullptr;
+	}
+
+	/**
+	 * @param windows[out] the children, the earliest linked first
+	 * @param capacity[in] the maximum number of the children to get
+	 * @return the number of the children, greater than the capacity if some did not fit
+	 */
+	size_t children(Node const& node, PWindow* windows, size_t capacity) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < node.children.size() && i < capacity; ++i)
+		{
+			windows[i] = node.children[i]->window.lock();
+		}
+		return node.children.size();
+	}
+
+private:
+	mutable std::mutex m_mutex;
+
+	/**
+	 * a closed window has no parent, a window never takes it as its parent
+	 */
+	bool linked(Node const* node) const noexcept
+	{
+		return node == &root || (node != nullptr && node->parent != nullptr);
+	}
+
+	void remove(Node& node) noexcept
+	{
+		if (node.parent == nullptr) return;
+		std::vector<Node*>& siblings = node.parent->children;
+		for (size_t i = 0; i < siblings.size(); ++i)
+		{
+			if (siblings[i] == &node)
+			{
+				siblings.erase(siblings.begin() + i);
+				return;
+			}
+		}
+	}
+};
+
+#endif // !__WINDOWTREE_HPP
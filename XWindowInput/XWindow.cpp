@@ -1,16 +1,48 @@
 #define XRootWindow getXRootWindow
 #define Window HWindow
+#define Region XRegion
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/Xresource.h>
+#include <X11/Xatom.h>
+#include <X11/XKBlib.h>
+#include <X11/extensions/XShm.h>
 #undef XRootWindow
 #undef Window
+#undef Region
 
 #include "../WindowInput/Window.hpp"
-
+#include "../WindowInput/EventQueue.hpp"
+#include "../WindowInput/FramePacer.hpp"
+#include "../WindowInput/Instrumentation.hpp"
+#include "../WindowInput/KeyState.hpp"
+#include "../WindowInput/LiveResize.hpp"
+#include "../WindowInput/PointerHistory.hpp"
+#include "../WindowInput/Trace.hpp"
+#include "../WindowInput/Region.hpp"
+#include "../WindowInput/Surface.hpp"
+#include "../WindowInput/WindowListeners.hpp"
+#include "../WindowInput/WindowMemory.hpp"
+#include "../WindowInput/WindowTitle.hpp"
+#include "../WindowInput/WindowTree.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <thread>
+#include <unordered_set>
 #include <vector>
 
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <unistd.h>
+
 #define MWM_HINTS_FUNCTIONS     (1L << 0)
 #define MWM_HINTS_DECORATIONS   (1L << 1)
 
@@ -29,6 +61,58 @@
 #define MWM_FUNC_MAXIMIZE       (1L << 4)
 #define MWM_FUNC_CLOSE          (1L << 5)
 
+#define X_ATOMS(X) \
+    X(WM_PROTOCOLS) \
+    X(WM_DELETE_WINDOW) \
+    X(WM_STATE) \
+    X(WM_CHANGE_STATE) \
+    X(UTF8_STRING) \
+    X(_MOTIF_WM_HINTS) \
+    X(_NET_CLOSE_WINDOW) \
+    X(_NET_ACTIVE_WINDOW) \
+    X(_NET_WM_NAME) \
+    X(_NET_WM_ICON_NAME) \
+    X(_NET_WM_PID) \
+    X(_NET_WM_PING) \
+    X(_NET_WM_STATE) \
+    X(_NET_WM_STATE_ABOVE) \
+    X(_NET_WM_STATE_FULLSCREEN) \
+    X(_NET_WM_STATE_HIDDEN) \
+    X(_NET_WM_STATE_MAXIMIZED_HORZ) \
+    X(_NET_WM_STATE_MAXIMIZED_VERT) \
+    X(_NET_WM_WINDOW_OPACITY) \
+    X(_NET_WM_WINDOW_TYPE) \
+    X(_NET_WM_WINDOW_TYPE_DIALOG) \
+    X(_NET_WM_WINDOW_TYPE_NORMAL) \
+    X(_WINDOWINPUT_FRAME) \
+    X(_WINDOWINPUT_RESIZE) \
+    X(_WINDOWINPUT_HIBERNATE)
+
+/**
+ * Atom Table of a Display
+ * interned in one XInternAtoms round trip when the display is opened
+ */
+struct XAtoms final
+{
+#define X_ATOM_FIELD(name) Atom name = None;
+    X_ATOMS(X_ATOM_FIELD)
+#undef X_ATOM_FIELD
+
+    explicit XAtoms(Display* display) noexcept
+    {
+#define X_ATOM_NAME(name) const_cast<char*>(#name),
+        char* names[] { X_ATOMS(X_ATOM_NAME) };
+#undef X_ATOM_NAME
+        Atom atoms[sizeof names / sizeof *names] {};
+        WINSTRUMENT_COUNT(WCOUNTER_ROUNDTRIPS);
+        if (XInternAtoms(display, names, sizeof names / sizeof *names, False, atoms) == 0) return;
+        Atom const* atom = atoms;
+#define X_ATOM_ASSIGN(name) name = *atom++;
+        X_ATOMS(X_ATOM_ASSIGN)
+#undef X_ATOM_ASSIGN
+    }
+};
+
 static XContext xUniqueContext() noexcept
 {
     static XContext context = XUniqueContext();
@@ -40,6 +124,7 @@ EXTERN_C XID xCreateWindow(
     short width, short height,
 	XID parentId,
 	Screen* screen,
+	Atom mwm_wm_hints,
 	void* pData = nullptr
 ) noexcept
 {
@@ -53,8 +138,7 @@ EXTERN_C XID xCreateWindow(
         XSaveContext(display, xid, xUniqueContext(), static_cast<char*>(pData));
     }
 
-    static Atom mwm_wm_hints = XInternAtom(display,"_MOTIF_WM_HINTS", False);
-    if (mwm_wm_hints == 0) return xid;
+    if (mwm_wm_hints == None) return xid;
 
     struct {
         unsigned long flags;
@@ -94,373 +178,2167 @@ EXTERN_C XID xCreateWindow(
 
 static PWindow root_window{ nullptr };
 
-struct XWindow final : IWindow
-{
-    Screen* m_screen = nullptr;
-    XID m_handle = 0;
+static std::atomic<unsigned int> event_threads{ 1 };
 
-private:
-	XWindow(char const* title, int style, short width, short height, XID parentId, Screen* screen)
-	    : m_screen(screen)
-		, m_handle(xCreateWindow(style, width, height, parentId, m_screen))
-	{
-        setTitle(title);
-	}
+static std::atomic<unsigned int> frame_rate{ 60 };
 
-	XWindow(wchar_t const* title, int style, short width, short height, XID parentId, Screen* screen)
-            : m_screen(screen)
-            , m_handle(xCreateWindow(style, width, height, parentId, m_screen))
-	{
-        setTitle(title);
-	}
+static std::atomic<bool> auto_flush{ false };
+
+static std::atomic<unsigned int> hibernate_after{ 0 };
+
+// the display whose events the calling thread dispatches, null for the threads of the application
+static thread_local Display* dispatching = nullptr;
+
+struct XWindow;
 
-    static int predicate(Display*, XEvent* e, XPointer xid) noexcept
+/**
+ * Event Thread of a Pool
+ * dispatches the events of the windows sharded to it in the order the dispatcher read them
+ */
+struct XEventWorker final
+{
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<XEvent> m_events;
+    bool m_running = true;
+    // whether the requests of the listeners are sent once the events queued are dispatched
+    bool const m_autoFlush;
+    std::thread m_thread;
+
+    XEventWorker(Display* display, bool autoFlush)
+        : m_autoFlush(autoFlush)
+        , m_thread(&XEventWorker::loop, this, display)
     {
-        return e->xany.window == reinterpret_cast<XID>(xid);
     }
 
-    static void loop(std::shared_ptr<XWindow> window) noexcept
+    ~XEventWorker() noexcept
     {
-	    if (window == nullptr) return;
-
-		Display* display = DisplayOfScreen(window->m_screen);
-		XID xid = window->m_handle;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_condition.notify_one();
+        if (m_thread.joinable()) m_thread.join();
+    }
 
-		static Atom WM_PROTOCOLS = XInternAtom(display, "WM_PROTOCOLS", False);
-		static Atom WM_DELETE_WINDOW = XInternAtom(display, "WM_DELETE_WINDOW", False);
-        XSetWMProtocols(display, xid, &WM_DELETE_WINDOW, 1);
+    void push(XEvent const& e)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_events.push_back(e);
+            WINSTRUMENT_DEPTH(WQUEUE_DISPATCH, m_events.size());
+        }
+        m_condition.notify_one();
+    }
 
-        XSaveContext(display, xid, xUniqueContext(), static_cast<char*>(static_cast<void*>(&window)));
+private:
+    void loop(Display* display) noexcept;
+};
 
-        XEvent e;
-        bool looping = true;
-        while (looping)
+/**
+ * Display Event Dispatcher
+ *
+ * the only thread reading events of a Display, it blocks on the connection fd
+ * and routes every event to its window through xUniqueContext(),
+ * either dispatching it itself or handing it to the event thread the window is sharded to
+ */
+struct XDispatcher final
+{
+    Display* const m_display;
+    XAtoms const m_atoms;
+    // the type of the MIT-SHM completion events, -1 without MIT-SHM
+    int const m_shmCompletion;
+    // the windows created on the display, the root node is the root window of the display
+    WindowTree m_tree;
+    // the input method of the display, null if the locale has none
+    XIM m_im = nullptr;
+    int m_wakeup[2] { -1, -1 };
+    std::atomic<bool> m_running{ true };
+    // the period of the frame ticks, the core protocol does not tell the refresh of the display
+    std::chrono::microseconds const m_frameInterval;
+    // the pause in the size changes ending a live resize, the core protocol does not tell the drags of the window manager
+    std::chrono::microseconds const m_resizePause{ 100000 };
+    // whether the requests of the listeners are sent once the events read together are dispatched
+    bool const m_autoFlush;
+    // the time a window stays hidden or minimized before it hibernates, 0 to never hibernate
+    std::chrono::microseconds const m_hibernateAfter;
+    // the number of the batches open, the calls send no requests meanwhile
+    std::atomic<unsigned int> m_batches{ 0 };
+    std::thread m_thread;
+
+    /**
+     * @param threads[in] the number of the event threads, 1 for the dispatcher thread only
+     * @param rate[in] the frames per second
+     * @param autoFlush[in] whether to flush at the end of a dispatch @see setAutoFlush
+     * @param hibernate[in] the milliseconds before a hidden window hibernates @see setHibernation
+     */
+    XDispatcher(Display* display, unsigned int threads, unsigned int rate, bool autoFlush, unsigned int hibernate)
+        : m_display(display)
+        , m_atoms(display)
+        , m_shmCompletion(XShmQueryExtension(display) ? XShmGetEventBase(display) + ShmCompletion : -1)
+        , m_frameInterval(1000000 / (rate ? rate : 60))
+        , m_autoFlush(autoFlush)
+        , m_hibernateAfter(std::chrono::milliseconds(hibernate))
+    {
+        if (pipe2(m_wakeup, O_CLOEXEC | O_NONBLOCK) != 0)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            if (XCheckIfEvent(display, &e, predicate, reinterpret_cast<XPointer>(xid)))
-            {
-                switch (e.type)
-                {
-                    case DestroyNotify:
-                        looping = false;
-						break;
-
-                    case ClientMessage:
-                        if (e.xclient.message_type == WM_PROTOCOLS)
-                        {
-                            if (static_cast<Atom>(e.xclient.data.l[0]) == WM_DELETE_WINDOW)
-                            {
-                                looping = false;
-                                break;
-                            }
-                        }
-                        break;
-                }
-            }
+            m_wakeup[0] = m_wakeup[1] = -1;
         }
-        XDeleteContext(display, xid, xUniqueContext());
-        XDestroyWindow(display, xid);
-        window->m_handle = 0;
-        XFlush(display);
+        // a held key repeats KeyPress only instead of KeyRelease and KeyPress pairs
+        XkbSetDetectableAutoRepeat(display, True, nullptr);
+        XSetLocaleModifiers("");
+        m_im = XOpenIM(display, nullptr, nullptr, nullptr);
+        for (unsigned int i = 0; threads > 1 && i < threads; ++i)
+        {
+            m_workers.emplace_back(new XEventWorker(display, autoFlush));
+        }
+        m_thread = std::thread(&XDispatcher::loop, this);
     }
 
-public:
-	static std::shared_ptr<XWindow> create(char const* title, int style, short width, short height, XID parentId, Screen* screen)
+    /**
+     * join the threads and forget the windows still open,
+     * closing the display afterwards destroys their native windows
+     */
+    ~XDispatcher() noexcept;
+
+    void add(XWindow* window)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_windows.insert(window);
+    }
+
+    void remove(XWindow* window) noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_windows.erase(window);
+        m_framed.erase(window);
+        m_resizing.erase(window);
+        m_idle.erase(window);
+    }
+
+    /**
+     * start or stop the frame ticks of a window
+     */
+    void frames(XWindow* window, bool enabled)
     {
-        std::shared_ptr<XWindow> shared_ptr{ nullptr };
-        std::thread([title, style, width, height, parentId, screen, &shared_ptr]() {
-            shared_ptr = std::shared_ptr<XWindow>(new XWindow(title, style, width, height, parentId, screen));
-            loop(shared_ptr);
-        }).detach();
-        while (!shared_ptr)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // a window closed meanwhile is not open anymore
+            if (enabled && m_windows.count(window)) m_framed.insert(window);
+            else m_framed.erase(window);
         }
-        return shared_ptr;
+        wake();
     }
 
-    static std::shared_ptr<XWindow> create(wchar_t const* title, int style, short width, short height, XID parentId, Screen* screen)
+    /**
+     * watch a window in a live resize for the pause ending it
+     */
+    void resizing(XWindow* window)
     {
-        std::shared_ptr<XWindow> shared_ptr{ nullptr };
-        std::thread([title, style, width, height, parentId, screen, &shared_ptr]() {
-            shared_ptr = std::shared_ptr<XWindow>(new XWindow(title, style, width, height, parentId, screen));
-            loop(shared_ptr);
-        }).detach();
-        while (!shared_ptr)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_windows.count(window)) m_resizing.insert(window);
         }
-        return shared_ptr;
+        wake();
     }
 
-    ~XWindow() noexcept override
+    /**
+     * watch a hidden or minimized window for the time it hibernates
+     */
+    void idle(XWindow* window)
     {
-        if (m_handle != 0)
         {
-            Display* display = DisplayOfScreen(m_screen);
-            XDeleteContext(display, m_handle, xUniqueContext());
-            XDestroyWindow(display, m_handle);
-            m_handle = 0;
-            XFlush(display);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_windows.count(window)) m_idle.insert(window);
         }
+        wake();
     }
 
-    PWindow create(char const* title, int style, short width, short height) const override
+    /**
+     * wake the dispatcher up
+     * a round trip of another thread may move events from the socket into the Xlib queue
+     * without making the connection fd readable, so such a call has to be followed by wake()
+     */
+    void wake() const noexcept
     {
-        return PWindow(create(title, style, width, height, m_handle, m_screen));
+        char const byte = 0;
+        if (m_wakeup[1] != -1 && write(m_wakeup[1], &byte, 1) < 0) {}
     }
 
-    PWindow create(wchar_t const* title, int style, short width, short height) const override
+    /**
+     * send the requests of a call, unless a batch holds them
+     * or the calling thread sends them at the end of its dispatch
+     */
+    void flush() const noexcept
     {
-        return PWindow(create(title, style, width, height, m_handle, m_screen));
+        if (m_batches.load(std::memory_order_acquire) != 0) return;
+        if (m_autoFlush && dispatching == m_display) return;
+        WINSTRUMENT_COUNT(WCOUNTER_FLUSHES);
+        XFlush(m_display);
     }
 
-    PWindow create(int style, short width, short height) const override
+    void openBatch() noexcept
     {
-        return PWindow(create(static_cast<char const*>(nullptr), style, width, height, m_handle, m_screen));
+        m_batches.fetch_add(1, std::memory_order_acq_rel);
     }
 
-	void show() const noexcept override
-	{
-		XMapWindow(DisplayOfScreen(m_screen), m_handle);
-	}
-
-    void minimize() const noexcept override
+    /**
+     * @see flush, the requests held by the last batch are sent by the thread ending it
+     */
+    void endBatch() noexcept
     {
-	    Display* display = DisplayOfScreen(m_screen);
-		XIconifyWindow(display, m_handle, DefaultScreen(display));
+        if (m_batches.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        WINSTRUMENT_COUNT(WCOUNTER_FLUSHES);
+        XFlush(m_display);
     }
 
-    void hide() const noexcept override
-	{
-		XUnmapWindow(DisplayOfScreen(m_screen), m_handle);
-	}
+    /**
+     * run a function on the dispatcher thread, right away if called by the dispatcher thread
+     * @return a future of the result of the function
+     */
+    template<typename Function>
+    auto invoke(Function&& function) -> std::future<decltype(function())>
+    {
+        using Result = decltype(function());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        std::future<Result> future = task->get_future();
+        if (std::this_thread::get_id() == m_thread.get_id())
+        {
+            (*task)();
+            return future;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.emplace_back([task]() { (*task)(); });
+        }
+        wake();
+        return future;
+    }
 
-    void close() const noexcept override
+    /**
+     * whether an event makes the previous one of a window obsolete,
+     * the consecutive resizes and motions of a window collapse into the latest one
+     */
+    static bool supersedes(XEvent const& next, XEvent const& e) noexcept
     {
-        Display* display = DisplayOfScreen(m_screen);
-		XEvent event;
-		event.xclient.type = ClientMessage;
-		event.xclient.serial = 0;
-		event.xclient.send_event = True;
-		event.xclient.window = m_handle;
-		static Atom _NET_CLOSE_WINDOW = XInternAtom(display, "_NET_CLOSE_WINDOW", False);
-        event.xclient.message_type = _NET_CLOSE_WINDOW;
-		event.xclient.format = 32;
-		event.xclient.data = { 0L, 0L, 0L, 0L, 0L };
-		XSendEvent(display, RootWindowOfScreen(m_screen), False, SubstructureNotifyMask | SubstructureRedirectMask, &event);
-		XSync(display, False);
+        return next.type == e.type && next.xany.window == e.xany.window && (e.type == ConfigureNotify || e.type == MotionNotify);
     }
 
-    bool isClosed() const noexcept override
+    /**
+     * @return the tree node of a window of the display, null for a window the library has not created
+     */
+    WindowTree::Node* node(XID xid) const noexcept;
+
+    /**
+     * dispatch an event to its window on the calling thread
+     * @param superseded[in] whether a newer event of the window is queued already @see supersedes
+     */
+    static void route(Display* display, XEvent& e, bool superseded) noexcept;
+
+    /**
+     * dispatch an event on the dispatcher thread or hand it to the event thread of its window
+     */
+    void post(XEvent& e) noexcept
     {
-        return m_handle == 0;
+        // a completion stays on this thread, the event thread of its window may be waiting for it in a present
+        if (m_workers.empty() || e.type == m_shmCompletion)
+        {
+            // only the events read already are looked at, peeking does not wait for the next ones
+            XEvent next;
+            route(m_display, e, XEventsQueued(m_display, QueuedAlready) > 0 && (XPeekEvent(m_display, &next), supersedes(next, e)));
+        }
+        else
+        {
+            WTRACE_INSTANT("handoff", e.type);
+            // all the events of a window go to one event thread to keep their order
+            m_workers[e.xany.window % m_workers.size()]->push(e);
+        }
     }
 
-    static unsigned int state(Display* display, XID xid) noexcept
+private:
+    std::mutex m_mutex;
+    std::vector<std::function<void()>> m_tasks;
+    std::vector<std::unique_ptr<XEventWorker>> m_workers;
+    std::unordered_set<XWindow*> m_windows;
+    // the windows requesting frames
+    std::unordered_set<XWindow*> m_framed;
+    // the windows in a live resize
+    std::unordered_set<XWindow*> m_resizing;
+    // the windows hidden or minimized and not hibernating yet
+    std::unordered_set<XWindow*> m_idle;
+    std::chrono::steady_clock::time_point m_nextFrame;
+    std::vector<XEvent> m_messages;
+
+    /**
+     * queue a client message of the dispatcher to a window
+     */
+    void message(XWindow const* window, Atom type);
+
+    /**
+     * post the frames due to the windows requesting them, the ends of the live resizes and the hibernations
+     * @param deadline[out] the time of the next tick
+     * @return whether a next tick is due
+     */
+    bool tick(std::chrono::steady_clock::time_point& deadline) noexcept;
+
+    void run() noexcept
     {
-        static Atom WM_STATE = XInternAtom(display, "WM_STATE", False);
-        Atom actual_type = 0;
-        int actual_format;
-        unsigned long nitems = 0, bytes_after;
-        struct {
-            unsigned int state;
-            XID icon;
-        }* property = nullptr;
-        XGetWindowProperty(display, xid, WM_STATE, 0, ~0L, False, WM_STATE, &actual_type, &actual_format, &nitems, &bytes_after, static_cast<unsigned char**>(static_cast<void*>(&property)));
-        if (property == nullptr || nitems == 0 || actual_type != WM_STATE)
+        std::vector<std::function<void()>> tasks;
         {
-            return WithdrawnState;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            tasks.swap(m_tasks);
+        }
+        for (std::function<void()>& task : tasks)
+        {
+            task();
         }
-        unsigned int state = property->state;
-        XFree(property);
-        return state;
     }
 
-    bool isVisible() const noexcept override
+    void loop() noexcept;
+};
+
+/**
+ * Window State Mirror
+ * written by the dispatcher from the event stream, read by the getters without a round trip
+ */
+struct XWindowState
+{
+    // the low-order word specifies a width of the client area (LOWORD)
+    // the high-order word specifies a height of the client area (HIWORD)
+    std::atomic<unsigned int> size{ 0 };
+
+    // the low-order word specifies a X-coordinate of the window (LOWORD)
+    // the high-order word specifies a Y-coordinate of the window (HIWORD)
+    std::atomic<unsigned int> position{ 0 };
+
+    // the low-order word specifies a X-coordinate of the cursor (LOWORD)
+    // the high-order word specifies a Y-coordinate of the cursor (HIWORD)
+    std::atomic<unsigned int> cursor{ 0 };
+
+    // IsUnmapped or IsViewable, the map state of the ancestors is not tracked
+    std::atomic<int> map_state{ IsUnmapped };
+
+    // WithdrawnState, NormalState or IconicState as the window manager reports in WM_STATE
+    std::atomic<unsigned int> wm_state{ WithdrawnState };
+
+    // whether the window is the focus window
+    std::atomic<bool> focused{ false };
+
+    // the title in UTF-8, cached when it is set and when WM_NAME changes
+    WindowTitle title;
+
+    static unsigned int pack(int low, int high) noexcept
     {
-        unsigned int state = XWindow::state(DisplayOfScreen(m_screen), m_handle);
-        return state != WithdrawnState && state != IconicState;
+        return static_cast<unsigned short>(low) | static_cast<unsigned int>(static_cast<unsigned short>(high)) << 16;
     }
 
-    bool isHidden() const noexcept override
+    static void unpack(unsigned int value, short& low, short& high) noexcept
     {
-        XWindowAttributes attributes{};
-        XGetWindowAttributes(DisplayOfScreen(m_screen), m_handle, &attributes);
-        return attributes.map_state != IsViewable;
+        low = static_cast<short>(value & 0xffff);
+        high = static_cast<short>(value >> 16);
     }
+};
 
-    bool isActive() const noexcept override
+/**
+ * cache the text of a text property in UTF-8, converted by Xlib without a round trip
+ */
+static void xStoreTitle(Display* display, XTextProperty const& property, WindowTitle& title) noexcept
+{
+    std::pmr::string text(windowMemory());
+    char** list = nullptr;
+    int count = 0;
+    if (property.value != nullptr && Xutf8TextPropertyToTextList(display, &property, &list, &count) >= Success && list != nullptr)
     {
-		XID focus = 0;
-		int revert_to;
-		XGetInputFocus(DisplayOfScreen(m_screen), &focus, &revert_to);
-        return focus == m_handle;
+        for (int i = 0; i < count; ++i)
+        {
+            text += list[i];
+        }
+        XFreeStringList(list);
     }
+    title.store(std::move(text));
+}
 
-    void getClientSize(short& width, short& height) const noexcept override
+/**
+ * Framebuffer Surface of a Window
+ * two images in MIT-SHM segments the server reads in place,
+ * or two client images copied through the socket by XPutImage if the server is remote or has no MIT-SHM
+ */
+struct XSurface final : Surface
+{
+    /**
+     * @param shm[in] whether the server has MIT-SHM
+     */
+    XSurface(XDispatcher const& dispatcher, XID xid, Screen* screen, short width, short height, bool shm) noexcept
+        : Surface(width, height)
+        , m_dispatcher(dispatcher)
+        , m_display(dispatcher.m_display)
+        , m_window(xid)
     {
-		XWindowAttributes attributes{};
-		XGetWindowAttributes(DisplayOfScreen(m_screen), m_handle, &attributes);
-		width = attributes.width;
-		height = attributes.height;
+        Display* display = m_display;
+        Visual* visual = m_visual = DefaultVisualOfScreen(screen);
+        int depth = m_depth = DefaultDepthOfScreen(screen);
+        if (depth < 24 || visual->red_mask != 0xff0000 || visual->green_mask != 0xff00 || visual->blue_mask != 0xff) return;
+
+        // the shared memory is of no use for a server on another host
+        char const* name = DisplayString(display);
+        m_shm = shm && (name[0] == ':' || std::strncmp(name, "unix:", 5) == 0)
+            && createShared(0, visual, depth) && (createShared(1, visual, depth) || destroyShared(0, true));
+        if (!m_shm && !(createLocal(0, visual, depth) && (createLocal(1, visual, depth) || destroyLocal(0)))) return;
+        if (m_shm)
+        {
+            // the segments vanish with their last attachment, the server's included
+            WINSTRUMENT_COUNT(WCOUNTER_ROUNDTRIPS);
+            XSync(display, False);
+            shmctl(m_segments[0].shmid, IPC_RMID, nullptr);
+            shmctl(m_segments[1].shmid, IPC_RMID, nullptr);
+        }
+        m_gc = XCreateGC(display, xid, 0, nullptr);
+        m_pitch = m_images[0]->bytes_per_line / 4;
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            m_buffers[i] = reinterpret_cast<unsigned int*>(m_images[i]->data);
+        }
     }
 
-    void getClientCursorPos(short& x, short& y) const noexcept override
+    ~XSurface() noexcept override
     {
-        XID root, child;
-        int root_x, root_y, win_x, win_y;
-        unsigned int mask;
-        XQueryPointer(DisplayOfScreen(m_screen), m_handle, &root, &child, &root_x, &root_y, &win_x, &win_y, &mask);
-        x = win_x;
-        y = win_y;
+        release();
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            if (m_segments[i].shmaddr) shmdt(m_segments[i].shmaddr);
+            else std::free(m_data[i]);
+        }
     }
 
-    Title getTitle() const noexcept override
+    bool valid() const noexcept
     {
-        XTextProperty property{};
-        XGetWMName(DisplayOfScreen(m_screen), m_handle, &property);
-        switch (property.format)
+        return m_buffers[0] != nullptr;
+    }
+
+    /**
+     * free the server resources while the window and the display are alive, the pixels stay
+     */
+    void release() noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_window == 0) return;
+        m_window = 0;
+        for (unsigned int i = 0; i < 2; ++i)
         {
-            case 8:
-                return std::string(static_cast<char const*>(static_cast<void const*>(property.value)));
-            case 16:
-                return std::wstring(static_cast<wchar_t const*>(static_cast<void const*>(property.value)));
-            default:
-                return {};
+            if (m_images[i] == nullptr) continue;
+            if (m_segments[i].shmaddr) XShmDetach(m_display, &m_segments[i]);
+            m_images[i]->data = nullptr;
+            XDestroyImage(m_images[i]);
+            m_images[i] = nullptr;
+            m_busy[i] = false;
         }
+        if (m_gc) XFreeGC(m_display, m_gc);
+        m_gc = nullptr;
+        m_condition.notify_all();
     }
 
-    void setTitle(char const* title) const noexcept override
+    /**
+     * free the front buffer with its server resources while the window is hibernating,
+     * the back buffer keeps the pixels presented last and the presents meanwhile only gather their damage
+     */
+    void suspend() noexcept
     {
-        Display* display = DisplayOfScreen(m_screen);
-        char* list[] { const_cast<char*>(title) };
-        XTextProperty property;
-        XmbTextListToTextProperty(display, list, 1, XStdICCTextStyle, &property);
-        XSetWMName(display, m_handle, &property);
-        XSetWMIconName(display, m_handle, &property);
-        XFree(property.value);
-        XFlush(display);
+        std::lock_guard<std::mutex> presenting(m_presenting);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_window == 0 || m_suspended) return;
+        m_suspended = true;
+        unsigned int const front = m_back ^ 1;
+        m_buffers[front] = nullptr;
+        m_busy[front] = false;
+        m_shm ? destroyShared(front, true) : destroyLocal(front);
+        m_condition.notify_all();
     }
 
-    void setTitle(wchar_t const* title) const noexcept override
+    /**
+     * allocate the front buffer again, a failure is retried by the next present
+     */
+    void resume() noexcept
     {
-        Display* display = DisplayOfScreen(m_screen);
-        wchar_t* list[] { const_cast<wchar_t*>(title) };
-		XTextProperty property;
-		XwcTextListToTextProperty(display, list, 1, XStdICCTextStyle, &property);
-		XSetWMName(display, m_handle, &property);
-		XSetWMIconName(display, m_handle, &property);
-		XFree(property.value);
-		XFlush(display);
+        std::lock_guard<std::mutex> presenting(m_presenting);
+        m_suspended = false;
+        restore();
     }
 
-	PWindow getParent() const override {
-        Display *display = DisplayOfScreen(m_screen);
-        XID root;
-        XID parent;
-        XID *children;
-        unsigned int nchildren;
-        XQueryTree(display, m_handle, &root, &parent, &children, &nchildren);
-        XFree(children);
+    void present() noexcept override
+    {
+        std::lock_guard<std::mutex> presenting(m_presenting);
+        if (m_suspended || !restore()) return;
+        Surface::present();
+    }
 
-        if (parent == root) return PWindow(root_window);
+    /**
+     * @return whether the server may still read a buffer presented before
+     */
+    bool pending() noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_busy[0] || m_busy[1];
+    }
 
-        PWindow const *result = nullptr;
-        XFindContext(display, parent, xUniqueContext(), (XPointer *) &result);
+    /**
+     * the server has read a segment
+     */
+    void complete(ShmSeg shmseg) noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            if (m_segments[i].shmseg == shmseg) m_busy[i] = false;
+        }
+        m_condition.notify_all();
+    }
 
-        return result == nullptr ? nullptr : PWindow(*result);
+protected:
+    void push(unsigned int buffer, Region const& damage) noexcept override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_window == 0) return;
+        for (WindowRect const* rect = damage.begin(); rect != damage.end(); ++rect)
+        {
+            if (m_shm)
+            {
+                // one completion event for the last region tells the segment is free again
+                XShmPutImage(m_display, m_window, m_gc, m_images[buffer], rect->x, rect->y, rect->x, rect->y, rect->width, rect->height, rect + 1 == damage.end());
+            }
+            else
+            {
+                XPutImage(m_display, m_window, m_gc, m_images[buffer], rect->x, rect->y, rect->x, rect->y, rect->width, rect->height);
+            }
+        }
+        m_busy[buffer] = m_shm;
+        WINSTRUMENT_COUNT(WCOUNTER_FLUSHES);
+        XFlush(m_display);
     }
-};
 
-typedef struct XRootWindow final : IWindow
-{
-    Screen* m_screen;
+    bool wait(unsigned int buffer) noexcept override
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_busy[buffer] || m_window == 0) return true;
+        if (dispatching == m_display)
+        {
+            // a present from a listener runs on a thread delivering the completions, it takes them off the queue itself,
+            // the server has sent the completion once the round trip returns
+            XID const xid = m_window;
+            lock.unlock();
+            WINSTRUMENT_COUNT(WCOUNTER_ROUNDTRIPS);
+            XSync(m_display, False);
+            XEvent e;
+            while (XCheckTypedWindowEvent(m_display, xid, m_dispatcher.m_shmCompletion, &e))
+            {
+                complete(reinterpret_cast<XShmCompletionEvent&>(e).shmseg);
+            }
+            lock.lock();
+        }
+        // the dispatcher thread completes the segments of the presents from the other threads
+        return m_condition.wait_for(lock, std::chrono::milliseconds(100), [this, buffer]() { return !m_busy[buffer] || m_window == 0; });
+    }
 
-public:
-    XRootWindow() noexcept
+private:
+    // used while the window is open only, the dispatcher releases the surfaces of its windows
+    XDispatcher const& m_dispatcher;
+    Display* const m_display;
+    XID m_window;
+    GC m_gc = nullptr;
+    bool m_shm = false;
+    XImage* m_images[2]{ nullptr, nullptr };
+    XShmSegmentInfo m_segments[2]{};
+    void* m_data[2]{ nullptr, nullptr };
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_busy[2]{ false, false };
+    Visual* m_visual = nullptr;
+    int m_depth = 0;
+    // serializes the presents with the suspends and the resumes
+    std::mutex m_presenting;
+    bool m_suspended = false;
+
+    /**
+     * allocate the front buffer freed by a suspend, called with m_presenting locked
+     * @return whether the surface has both buffers
+     */
+    bool restore() noexcept
     {
-        XInitThreads();
-        Display* display = XOpenDisplay(nullptr);
-        int screenId = DefaultScreen(display);
-        m_screen = ScreenOfDisplay(display, screenId);
+        unsigned int const front = m_back ^ 1;
+        if (m_buffers[front]) return true;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_window == 0) return false;
+        if (m_shm)
+        {
+            if (!createShared(front, m_visual, m_depth)) return false;
+            WINSTRUMENT_COUNT(WCOUNTER_ROUNDTRIPS);
+            XSync(m_display, False);
+            m_dispatcher.wake();
+            shmctl(m_segments[front].shmid, IPC_RMID, nullptr);
+        }
+        else if (!createLocal(front, m_visual, m_depth))
+        {
+            return false;
+        }
+        m_buffers[front] = reinterpret_cast<unsigned int*>(m_images[front]->data);
+        return true;
     }
 
-    ~XRootWindow() override
+    bool createShared(unsigned int i, Visual* visual, int depth) noexcept
     {
-		XCloseDisplay(DisplayOfScreen(m_screen));
+        XShmSegmentInfo& segment = m_segments[i];
+        m_images[i] = XShmCreateImage(m_display, visual, depth, ZPixmap, nullptr, &segment, m_width, m_height);
+        if (m_images[i] == nullptr || m_images[i]->bits_per_pixel != 32) return destroyShared(i, false);
+        segment.shmid = shmget(IPC_PRIVATE, m_images[i]->bytes_per_line * m_height, IPC_CREAT | 0600);
+        if (segment.shmid == -1) return destroyShared(i, false);
+        segment.shmaddr = m_images[i]->data = static_cast<char*>(shmat(segment.shmid, nullptr, 0));
+        if (segment.shmaddr == reinterpret_cast<char*>(-1))
+        {
+            shmctl(segment.shmid, IPC_RMID, nullptr);
+            segment.shmaddr = nullptr;
+            return destroyShared(i, false);
+        }
+        segment.readOnly = True;
+        XShmAttach(m_display, &segment);
+        return true;
     }
 
-    PWindow create(char const* title, int style, short width, short height) const override
+    /**
+     * undo a shared image
+     * @param attached[in] whether the server has attached the segment
+     * @return false
+     */
+    bool destroyShared(unsigned int i, bool attached) noexcept
     {
-        return PWindow(XWindow::create(title, style, width, height, RootWindowOfScreen(m_screen), m_screen));
+        XShmSegmentInfo& segment = m_segments[i];
+        if (segment.shmaddr)
+        {
+            if (attached) XShmDetach(m_display, &segment);
+            shmdt(segment.shmaddr);
+            shmctl(segment.shmid, IPC_RMID, nullptr);
+        }
+        segment = XShmSegmentInfo{};
+        if (m_images[i])
+        {
+            m_images[i]->data = nullptr;
+            XDestroyImage(m_images[i]);
+            m_images[i] = nullptr;
+        }
+        return false;
     }
 
-    PWindow create(wchar_t const* title, int style, short width, short height) const override
+    bool createLocal(unsigned int i, Visual* visual, int depth) noexcept
     {
-        return PWindow(XWindow::create(title, style, width, height, RootWindowOfScreen(m_screen), m_screen));
+        m_images[i] = XCreateImage(m_display, visual, depth, ZPixmap, 0, nullptr, m_width, m_height, 32, 0);
+        if (m_images[i] == nullptr) return false;
+        if (m_images[i]->bits_per_pixel != 32 || (m_data[i] = std::calloc(m_images[i]->bytes_per_line, m_height)) == nullptr)
+        {
+            XDestroyImage(m_images[i]);
+            m_images[i] = nullptr;
+            return false;
+        }
+        m_images[i]->data = static_cast<char*>(m_data[i]);
+        return true;
     }
 
-    PWindow create(int style, short width, short height) const override
+    /**
+     * @return false
+     */
+    bool destroyLocal(unsigned int i) noexcept
     {
-        return PWindow(XWindow::create(static_cast<char const*>(nullptr), style, width, height, RootWindowOfScreen(m_screen), m_screen));
+        if (m_images[i])
+        {
+            m_images[i]->data = nullptr;
+            XDestroyImage(m_images[i]);
+            m_images[i] = nullptr;
+        }
+        std::free(m_data[i]);
+        m_data[i] = nullptr;
+        return false;
     }
+};
 
-	void show() const noexcept override {}
+struct XWindow final : IWindow, std::enable_shared_from_this<XWindow>
+{
+    Screen* m_screen = nullptr;
+    XDispatcher& m_dispatcher;
+    std::atomic<XID> m_handle{ 0 };
 
-    void minimize() const noexcept override {}
+private:
+    // keeps a window alive while it is open, the dispatcher only holds raw pointers
+    std::shared_ptr<XWindow> m_self{ nullptr };
 
-    void hide() const noexcept override {}
+    mutable WindowListeners m_listeners;
 
-    void close() const noexcept override {}
+    mutable XWindowState m_state;
 
-	bool isClosed() const noexcept override { return false; }
+    mutable EventQueue m_events;
 
-	bool isVisible() const noexcept override { return false; }
+    mutable KeyState m_keys;
 
-	bool isHidden() const noexcept override { return false; }
+    mutable PointerHistory m_history;
 
-    bool isActive() const noexcept override
-    {
-        XID focus = 0;
-        int revert_to;
-        XGetInputFocus(DisplayOfScreen(m_screen), &focus, &revert_to);
-        return focus == RootWindowOfScreen(m_screen);
-    }
+    mutable std::shared_ptr<XSurface> m_surface{ nullptr };
 
-	void getClientSize(short& width, short& height) const noexcept override
+    mutable FramePacer m_pacer;
+
+    mutable WindowDamage m_damage;
+
+    mutable LiveResize m_resize;
+
+    // the time of the last size change, read by the dispatcher waiting for the end of a live resize
+    std::atomic<unsigned long long> m_resizeTime{ 0 };
+
+    // the time the window was hidden or minimized, read by the dispatcher waiting for its hibernation
+    std::atomic<unsigned long long> m_hiddenTime{ 0 };
+
+    // whether the window has left the frame ticks and suspended its surface until it is shown
+    std::atomic<bool> m_hibernating{ false };
+
+    // held while the hibernation flag and the frame ticks and the surface it stands for change together,
+    // the dispatcher hibernates a window while any thread may show it
+    mutable std::mutex m_hibernation;
+
+    // set when the dispatcher is released before the window is closed, the window is closed then
+    // and reaches neither the dispatcher nor the display anymore
+    std::atomic<bool> m_orphaned{ false };
+
+    // the input context of the window, null without an input method
+    XIC m_ic = nullptr;
+
+    WindowTree::Node m_node;
+
+	XWindow(char const* title, int style, short width, short height, XID parentId, Screen* screen, XDispatcher& dispatcher)
+	    : m_screen(screen)
+		, m_dispatcher(dispatcher)
+		, m_handle(xCreateWindow(style, width, height, parentId, m_screen, dispatcher.m_atoms._MOTIF_WM_HINTS))
 	{
-		width = m_screen->width;
-		height = m_screen->height;
+        m_state.size = XWindowState::pack(width, height);
+        applyTitle(title);
 	}
 
-    void getClientCursorPos(short& x, short& y) const noexcept override
+	XWindow(wchar_t const* title, int style, short width, short height, XID parentId, Screen* screen, XDispatcher& dispatcher)
+            : m_screen(screen)
+            , m_dispatcher(dispatcher)
+            , m_handle(xCreateWindow(style, width, height, parentId, m_screen, dispatcher.m_atoms._MOTIF_WM_HINTS))
+	{
+        m_state.size = XWindowState::pack(width, height);
+        applyTitle(title);
+	}
+
+    /**
+     * @param parentId[in] the parent the window has been created in
+     * @param flush[in] whether to flush the requests, the caller flushes them otherwise
+     */
+    static std::shared_ptr<XWindow> attach(std::shared_ptr<XWindow> window, XID parentId, bool flush = true) noexcept
     {
-        XID root, child;
-        int root_x, root_y, win_x, win_y;
-        unsigned int mask;
-        XQueryPointer(DisplayOfScreen(m_screen), RootWindowOfScreen(m_screen), &root, &child, &root_x, &root_y, &win_x, &win_y, &mask);
-		x = root_x;
-		y = root_y;
+        Display* display = DisplayOfScreen(window->m_screen);
+        XID xid = window->m_handle;
+
+        Atom protocols[] { window->m_dispatcher.m_atoms.WM_DELETE_WINDOW };
+        XSetWMProtocols(display, xid, protocols, 1);
+        long mask = StructureNotifyMask | FocusChangeMask | PointerMotionMask | EnterWindowMask | LeaveWindowMask | PropertyChangeMask
+            | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | ExposureMask;
+        if (XIM im = window->m_dispatcher.m_im)
+        {
+            window->m_ic = XCreateIC(im, XNInputStyle, XIMPreeditNothing | XIMStatusNothing, XNClientWindow, xid, XNFocusWindow, xid, nullptr);
+            long filter = 0;
+            if (window->m_ic && XGetICValues(window->m_ic, XNFilterEvents, &filter, nullptr) == nullptr)
+            {
+                mask |= filter;
+            }
+        }
+        XSelectInput(display, xid, mask);
+
+        window->m_self = window;
+        window->m_dispatcher.add(window.get());
+        XSaveContext(display, xid, xUniqueContext(), static_cast<char*>(static_cast<void*>(window.get())));
+        window->link(parentId, window);
+        if (flush)
+        {
+            window->m_dispatcher.flush();
+        }
+        return window;
     }
 
-    Title getTitle() const noexcept override
+    /**
+     * link the node of the window under the node of a parent, the top-level windows under the root window
+     */
+    void link(XID parentId, std::weak_ptr<IWindow const> window)
     {
+        XDispatcher& dispatcher = m_dispatcher;
+        XID const rootId = RootWindowOfScreen(m_screen);
+        dispatcher.m_tree.link(m_node, [&dispatcher, parentId, rootId]() {
+            return parentId == rootId ? &dispatcher.m_tree.root : dispatcher.node(parentId);
+        }, std::move(window));
+    }
+
+    /**
+     * set the title without flushing the requests
+     */
+    void applyTitle(char const* title) const noexcept
+    {
+        Display* display = DisplayOfScreen(m_screen);
+        char* list[] { const_cast<char*>(title ? title : "") };
+        XTextProperty property;
+        XmbTextListToTextProperty(display, list, 1, XStdICCTextStyle, &property);
+        XSetWMName(display, m_handle, &property);
+        XSetWMIconName(display, m_handle, &property);
+        xStoreTitle(display, property, m_state.title);
+        XFree(property.value);
+    }
+
+    /**
+     * set the title without flushing the requests
+     */
+    void applyTitle(wchar_t const* title) const noexcept
+    {
+        Display* display = DisplayOfScreen(m_screen);
+        wchar_t* list[] { const_cast<wchar_t*>(title ? title : L"") };
+		XTextProperty property;
+		XwcTextListToTextProperty(display, list, 1, XStdICCTextStyle, &property);
+		XSetWMName(display, m_handle, &property);
+		XSetWMIconName(display, m_handle, &property);
+        xStoreTitle(display, property, m_state.title);
+		XFree(property.value);
+    }
+
+    /**
+     * forget the native window, the last statement since it may release the window
+     * @param destroy[in] whether the native window still exists and has to be destroyed
+     */
+    void detach(bool destroy) noexcept
+    {
+        Display* display = DisplayOfScreen(m_screen);
+        XID xid = m_handle.exchange(0);
+        if (xid == 0) return;
+        // the node goes first, a child linking itself looks its parent up by the context
+        m_dispatcher.m_tree.unlink(m_node);
+        m_events.push(Event::make(WEVENT_CLOSE));
+        m_listeners.notify([this](IWindowListener& listener) { listener.onClose(*this); });
+        XDeleteContext(display, xid, xUniqueContext());
+        m_dispatcher.remove(this);
+        if (m_ic)
+        {
+            XDestroyIC(m_ic);
+            m_ic = nullptr;
+        }
+        if (std::shared_ptr<XSurface> surface = std::atomic_exchange(&m_surface, std::shared_ptr<XSurface>()))
+        {
+            surface->release();
+        }
+        if (destroy)
+        {
+            XDestroyWindow(display, xid);
+            m_dispatcher.flush();
+        }
+        std::shared_ptr<XWindow> self = std::move(m_self);
+    }
+
+    friend struct XDispatcher;
+
+public:
+    /**
+     * handle an event of the window, called by the event thread of the window only
+     * @param superseded[in] whether a newer event of the window is queued already, the listeners get the newer one only
+     */
+    void dispatch(XEvent& e, bool superseded) noexcept
+    {
+        WTRACE_SPAN("dispatch", e.type);
+        Display* display = DisplayOfScreen(m_screen);
+        XAtoms const& atoms = m_dispatcher.m_atoms;
+        switch (e.type)
+        {
+            case DestroyNotify:
+                if (e.xdestroywindow.window == m_handle)
+                {
+                    detach(false);
+                }
+                break;
+
+            case ConfigureNotify:
+                if (!superseded)
+                {
+                    short width = e.xconfigure.width, height = e.xconfigure.height;
+                    m_state.position = XWindowState::pack(e.xconfigure.x, e.xconfigure.y);
+                    if (m_state.size.exchange(XWindowState::pack(width, height)) != XWindowState::pack(width, height))
+                    {
+                        resized(width, height);
+                    }
+                }
+                break;
+
+            case Expose:
+                m_damage.add(e.xexpose.x, e.xexpose.y, e.xexpose.width, e.xexpose.height);
+                break;
+
+            case ReparentNotify:
+                {
+                    // the frame of a window manager is no parent the library knows, the window stays where it was
+                    XDispatcher& dispatcher = m_dispatcher;
+                    XID const parentId = e.xreparent.parent, rootId = RootWindowOfScreen(m_screen);
+                    dispatcher.m_tree.move(m_node, [&dispatcher, parentId, rootId]() {
+                        return parentId == rootId ? &dispatcher.m_tree.root : dispatcher.node(parentId);
+                    });
+                }
+                break;
+
+            case MapNotify:
+                m_state.map_state = IsViewable;
+                if (m_state.wm_state != IconicState) awake();
+                break;
+
+            case UnmapNotify:
+                m_state.map_state = IsUnmapped;
+                idle();
+                break;
+
+            case FocusIn:
+            case FocusOut:
+                // the virtual details only report the focus passing through the window
+                if (e.xfocus.detail == NotifyAncestor || e.xfocus.detail == NotifyInferior || e.xfocus.detail == NotifyNonlinear)
+                {
+                    bool active = e.type == FocusIn;
+                    if (m_ic)
+                    {
+                        active ? XSetICFocus(m_ic) : XUnsetICFocus(m_ic);
+                    }
+                    if (!active)
+                    {
+                        m_keys.clear();
+                    }
+                    if (m_state.focused.exchange(active) != active)
+                    {
+                        m_events.push(Event::make(WEVENT_FOCUS, active, 0, 0));
+                        m_listeners.notify([this, active](IWindowListener& listener) { listener.onFocus(*this, active); });
+                    }
+                }
+                break;
+
+            case EnterNotify:
+            case LeaveNotify:
+                m_state.cursor = XWindowState::pack(e.xcrossing.x, e.xcrossing.y);
+                break;
+
+            case MotionNotify:
+                {
+                    short x = e.xmotion.x, y = e.xmotion.y;
+                    m_state.cursor = XWindowState::pack(x, y);
+                    Event event = Event::make(WEVENT_MOTION, 0, x, y);
+                    m_history.record(x, y, event.time);
+                    if (superseded) break;
+                    m_events.push(event);
+                    m_listeners.notify([this, x, y](IWindowListener& listener) { listener.onPointerMove(*this, x, y); });
+                }
+                break;
+
+            case KeyPress:
+            case KeyRelease:
+                {
+                    short key = static_cast<short>(e.xkey.keycode);
+                    bool down = e.type == KeyPress;
+                    m_keys.set(static_cast<unsigned char>(key), down);
+                    m_events.push(Event::make(down ? WEVENT_KEYDOWN : WEVENT_KEYUP, key, e.xkey.x, e.xkey.y));
+                    m_listeners.notify([this, key, down](IWindowListener& listener) { listener.onKey(*this, key, down); });
+                    if (down)
+                    {
+                        text(e.xkey);
+                    }
+                }
+                break;
+
+            case ButtonPress:
+            case ButtonRelease:
+                // the buttons 4 and 5 are the notches of the wheel
+                if (e.xbutton.button == Button4 || e.xbutton.button == Button5)
+                {
+                    if (e.type == ButtonPress)
+                    {
+                        m_events.push(Event::make(WEVENT_WHEEL, e.xbutton.button == Button4 ? 120 : -120, e.xbutton.x, e.xbutton.y));
+                    }
+                }
+                else
+                {
+                    short button = e.xbutton.button == Button1 ? WBUTTON_LEFT
+                        : e.xbutton.button == Button2 ? WBUTTON_MIDDLE
+                        : e.xbutton.button == Button3 ? WBUTTON_RIGHT
+                        : static_cast<short>(e.xbutton.button);
+                    m_events.push(Event::make(e.type == ButtonPress ? WEVENT_BUTTONDOWN : WEVENT_BUTTONUP, button, e.xbutton.x, e.xbutton.y));
+                }
+                break;
+
+            case PropertyNotify:
+                if (e.xproperty.atom == XA_WM_NAME)
+                {
+                    XTextProperty property{};
+                    WINSTRUMENT_COUNT(WCOUNTER_ROUNDTRIPS);
+                    XGetWMName(display, m_handle, &property);
+                    xStoreTitle(display, property, m_state.title);
+                    if (property.value) XFree(property.value);
+                }
+                else if (e.xproperty.atom == atoms.WM_STATE)
+                {
+                    unsigned int const state = XWindow::state(display, m_handle, atoms.WM_STATE);
+                    if (m_state.wm_state.exchange(state) == state) break;
+                    if (state == IconicState) idle();
+                    else if (m_state.map_state == IsViewable) awake();
+                }
+                break;
+
+            default:
+                if (e.type == m_dispatcher.m_shmCompletion)
+                {
+                    if (std::shared_ptr<XSurface> surface = std::atomic_load(&m_surface))
+                    {
+                        surface->complete(reinterpret_cast<XShmCompletionEvent&>(e).shmseg);
+                    }
+                }
+                break;
+
+            case ClientMessage:
+                if (e.xclient.message_type == atoms._WINDOWINPUT_FRAME)
+                {
+                    // a frame rendered while the server still reads the previous one would stall its present
+                    std::shared_ptr<XSurface> const surface = std::atomic_load(&m_surface);
+                    // a minimized window stays mapped
+                    FrameStats stats;
+                    if (surface && surface->pending())
+                    {
+                        m_pacer.miss();
+                    }
+                    else if (m_pacer.frame(m_state.map_state == IsViewable && m_state.wm_state != IconicState, stats))
+                    {
+                        m_listeners.notify([this, &stats](IWindowListener& listener) { listener.onFrame(*this, stats); });
+                    }
+                }
+                else if (e.xclient.message_type == atoms._WINDOWINPUT_RESIZE)
+                {
+                    if (Event::now() - m_resizeTime < static_cast<unsigned long long>(m_dispatcher.m_resizePause.count()))
+                    {
+                        m_dispatcher.resizing(this);
+                    }
+                    else
+                    {
+                        bool held;
+                        if (m_resize.end(held))
+                        {
+                            short width, height;
+                            XWindowState::unpack(m_state.size, width, height);
+                            if (held)
+                            {
+                                notifyResize(width, height);
+                            }
+                            m_events.push(Event::make(WEVENT_LIVERESIZE, 0, width, height));
+                            m_listeners.notify([this](IWindowListener& listener) { listener.onLiveResize(*this, false); });
+                        }
+                    }
+                }
+                else if (e.xclient.message_type == atoms._WINDOWINPUT_HIBERNATE)
+                {
+                    if (m_state.map_state == IsViewable && m_state.wm_state != IconicState) break;
+                    if (Event::now() - m_hiddenTime < static_cast<unsigned long long>(m_dispatcher.m_hibernateAfter.count()))
+                    {
+                        m_dispatcher.idle(this);
+                    }
+                    else
+                    {
+                        hibernate();
+                    }
+                }
+                else if (e.xclient.message_type == atoms.WM_PROTOCOLS)
+                {
+                    if (static_cast<Atom>(e.xclient.data.l[0]) == atoms.WM_DELETE_WINDOW)
+                    {
+                        detach(true);
+                    }
+                }
+                break;
+        }
+    }
+
+    /**
+     * report a size change, a change soon after the previous one is taken for the user dragging the frame
+     */
+    void resized(short width, short height) noexcept
+    {
+        unsigned long long const now = Event::now();
+        unsigned long long const previous = m_resizeTime.exchange(now);
+        if (now - previous < static_cast<unsigned long long>(m_dispatcher.m_resizePause.count()) && m_resize.begin())
+        {
+            m_events.push(Event::make(WEVENT_LIVERESIZE, 1, width, height));
+            m_listeners.notify([this](IWindowListener& listener) { listener.onLiveResize(*this, true); });
+            m_dispatcher.resizing(this);
+        }
+        if (m_resize.hold(m_dispatcher.m_frameInterval.count())) return;
+        notifyResize(width, height);
+    }
+
+    /**
+     * start waiting for the hibernation of a window hidden or minimized
+     */
+    void idle() noexcept
+    {
+        if (m_dispatcher.m_hibernateAfter.count() == 0) return;
+        m_hiddenTime = Event::now();
+        m_dispatcher.idle(this);
+    }
+
+    /**
+     * release the frame ticks and the front buffer of the surface, the window state and the listeners stay
+     */
+    void hibernate() noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_hibernation);
+        if (m_hibernating.exchange(true)) return;
+        m_dispatcher.frames(this, false);
+        if (std::shared_ptr<XSurface> surface = std::atomic_load(&m_surface))
+        {
+            surface->suspend();
+        }
+    }
+
+    /**
+     * restore what the hibernation released, called by any thread
+     */
+    void awake() const noexcept
+    {
+        XWindow* self = const_cast<XWindow*>(this);
+        std::lock_guard<std::mutex> lock(m_hibernation);
+        if (!self->m_hibernating.exchange(false)) return;
+        if (std::shared_ptr<XSurface> surface = std::atomic_load(&m_surface))
+        {
+            surface->resume();
+        }
+        if (m_pacer.requested()) m_dispatcher.frames(self, true);
+    }
+
+    void notifyResize(short width, short height) noexcept
+    {
+        m_events.push(Event::make(WEVENT_RESIZE, 0, width, height));
+        m_listeners.notify([this, width, height](IWindowListener& listener) { listener.onResize(*this, width, height); });
+    }
+
+    /**
+     * report the characters typed by a key press,
+     * UTF-8 through the input context, Latin-1 without an input method
+     */
+    void text(XKeyEvent& e) noexcept
+    {
+        char buffer[64];
+        KeySym keysym;
+        int length;
+        bool utf8 = m_ic != nullptr;
+        if (utf8)
+        {
+            Status status;
+            length = Xutf8LookupString(m_ic, &e, buffer, sizeof buffer, &keysym, &status);
+            if (status != XLookupChars && status != XLookupBoth) length = 0;
+        }
+        else
+        {
+            length = XLookupString(&e, buffer, sizeof buffer, &keysym, nullptr);
+        }
+
+        unsigned char const* p = reinterpret_cast<unsigned char const*>(buffer);
+        unsigned char const* end = p + length;
+        while (p < end)
+        {
+            char32_t codepoint = *p++;
+            if (utf8 && codepoint >= 0x80)
+            {
+                int trailing = codepoint >= 0xf0 ? 3 : codepoint >= 0xe0 ? 2 : 1;
+                codepoint &= 0x3f >> trailing;
+                for (; trailing > 0 && p < end; --trailing)
+                {
+                    codepoint = codepoint << 6 | (*p++ & 0x3f);
+                }
+            }
+            m_events.push(Event::text(codepoint));
+            m_listeners.notify([this, codepoint](IWindowListener& listener) { listener.onText(*this, codepoint); });
+        }
+    }
+
+	static std::shared_ptr<XWindow> create(char const* title, int style, short width, short height, XID parentId, Screen* screen, XDispatcher& dispatcher)
+    {
+        // a closed parent has no children, its dispatcher may be released already
+        if (parentId == 0) return nullptr;
+        return attach(allocateWindow<XWindow>([=, &dispatcher](void* block) {
+            return new (block) XWindow(title, style, width, height, parentId, screen, dispatcher);
+        }), parentId);
+    }
+
+    static std::shared_ptr<XWindow> create(wchar_t const* title, int style, short width, short height, XID parentId, Screen* screen, XDispatcher& dispatcher)
+    {
+        if (parentId == 0) return nullptr;
+        return attach(allocateWindow<XWindow>([=, &dispatcher](void* block) {
+            return new (block) XWindow(title, style, width, height, parentId, screen, dispatcher);
+        }), parentId);
+    }
+
+    /**
+     * create windows with the requests pipelined and flushed once
+     */
+    static std::vector<PWindow> createMany(WindowSpec const* specs, size_t count, XID parentId, Screen* screen, XDispatcher& dispatcher)
+    {
+        std::vector<PWindow> windows;
+        if (parentId == 0) return windows;
+        windows.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            WindowSpec const& spec = specs[i];
+            std::shared_ptr<XWindow> window = allocateWindow<XWindow>([&spec, parentId, screen, &dispatcher](void* block) {
+                return spec.title != nullptr || spec.unicode == nullptr
+                    ? new (block) XWindow(spec.title, spec.style, spec.width, spec.height, parentId, screen, dispatcher)
+                    : new (block) XWindow(spec.unicode, spec.style, spec.width, spec.height, parentId, screen, dispatcher);
+            });
+            windows.emplace_back(attach(std::move(window), parentId, false));
+        }
+        dispatcher.flush();
+        return windows;
+    }
+
+    /**
+     * create a window on the dispatcher thread
+     * @param title[in] the window title, null for a window without a title
+     */
+    template<typename Char>
+    static std::future<PWindow> createAsync(std::basic_string<Char> title, bool titled, int style, short width, short height, XID parentId, Screen* screen, XDispatcher& dispatcher)
+    {
+        if (parentId == 0)
+        {
+            std::promise<PWindow> closed;
+            closed.set_value(nullptr);
+            return closed.get_future();
+        }
+        return dispatcher.invoke([title, titled, style, width, height, parentId, screen, &dispatcher]() -> PWindow {
+            return PWindow(create(titled ? title.c_str() : nullptr, style, width, height, parentId, screen, dispatcher));
+        });
+    }
+
+    ~XWindow() noexcept override
+    {
+        if (m_ic) XDestroyIC(m_ic);
+        XID xid = m_handle.exchange(0);
+        if (xid != 0)
+        {
+            Display* display = DisplayOfScreen(m_screen);
+            XDeleteContext(display, xid, xUniqueContext());
+            XDestroyWindow(display, xid);
+            // the dispatcher outlives the windows it has not detached
+            m_dispatcher.flush();
+        }
+    }
+
+    PWindow create(char const* title, int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATE);
+        return PWindow(create(title, style, width, height, m_handle, m_screen, m_dispatcher));
+    }
+
+    PWindow create(wchar_t const* title, int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATE);
+        return PWindow(create(title, style, width, height, m_handle, m_screen, m_dispatcher));
+    }
+
+    PWindow create(int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATE);
+        return PWindow(create(static_cast<char const*>(nullptr), style, width, height, m_handle, m_screen, m_dispatcher));
+    }
+
+    std::future<PWindow> createAsync(std::string title, int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+        return createAsync(std::move(title), true, style, width, height, m_handle, m_screen, m_dispatcher);
+    }
+
+    std::future<PWindow> createAsync(std::wstring title, int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+        return createAsync(std::move(title), true, style, width, height, m_handle, m_screen, m_dispatcher);
+    }
+
+    std::future<PWindow> createAsync(int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+        return createAsync(std::string(), false, style, width, height, m_handle, m_screen, m_dispatcher);
+    }
+
+    std::vector<PWindow> createMany(WindowSpec const* specs, size_t count) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATEMANY);
+        return createMany(specs, count, m_handle, m_screen, m_dispatcher);
+    }
+
+	void show() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_SHOW);
+		if (m_handle == 0) return;
+		// the surface is ready for the first present after the call
+		awake();
+		XMapWindow(DisplayOfScreen(m_screen), m_handle);
+        m_dispatcher.flush();
+	}
+
+    void minimize() const noexcept override
+    {
+	    WINSTRUMENT_CALL(WCALL_MINIMIZE);
+        if (m_handle == 0) return;
+	    Display* display = DisplayOfScreen(m_screen);
+		XIconifyWindow(display, m_handle, DefaultScreen(display));
+        m_dispatcher.flush();
+    }
+
+    void hide() const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_HIDE);
+		if (m_handle == 0) return;
+		XUnmapWindow(DisplayOfScreen(m_screen), m_handle);
+        m_dispatcher.flush();
+	}
+
+    void close() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_CLOSE);
+        if (m_handle == 0) return;
+        Display* display = DisplayOfScreen(m_screen);
+		XEvent event;
+		event.xclient.type = ClientMessage;
+		event.xclient.serial = 0;
+		event.xclient.send_event = True;
+		event.xclient.window = m_handle;
+        event.xclient.message_type = m_dispatcher.m_atoms._NET_CLOSE_WINDOW;
+		event.xclient.format = 32;
+		event.xclient.data = { 0L, 0L, 0L, 0L, 0L };
+		XSendEvent(display, RootWindowOfScreen(m_screen), False, SubstructureNotifyMask | SubstructureRedirectMask, &event);
+        // the window manager answers with events on the connection, no round trip is needed to see them
+        m_dispatcher.flush();
+    }
+
+    bool isClosed() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_ISCLOSED);
+        return m_handle == 0;
+    }
+
+    static unsigned int state(Display* display, XID xid, Atom WM_STATE) noexcept
+    {
+        Atom actual_type = 0;
+        int actual_format;
+        unsigned long nitems = 0, bytes_after;
+        struct {
+            unsigned int state;
+            XID icon;
+        }* property = nullptr;
+        WINSTRUMENT_COUNT(WCOUNTER_ROUNDTRIPS);
+        XGetWindowProperty(display, xid, WM_STATE, 0, ~0L, False, WM_STATE, &actual_type, &actual_format, &nitems, &bytes_after, static_cast<unsigned char**>(static_cast<void*>(&property)));
+        if (property == nullptr || nitems == 0 || actual_type != WM_STATE)
+        {
+            return WithdrawnState;
+        }
+        unsigned int state = property->state;
+        XFree(property);
+        return state;
+    }
+
+    bool isVisible() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_ISVISIBLE);
+        unsigned int state = m_state.wm_state;
+        return state != WithdrawnState && state != IconicState;
+    }
+
+    bool isHidden() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_ISHIDDEN);
+        return m_state.map_state != IsViewable;
+    }
+
+    bool isActive() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_ISACTIVE);
+        return m_state.focused;
+    }
+
+    void getClientSize(short& width, short& height) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_GETCLIENTSIZE);
+        XWindowState::unpack(m_state.size, width, height);
+    }
+
+    /**
+     * the position reported by the last pointer event of the window
+     */
+    void getClientCursorPos(short& x, short& y) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_GETCLIENTCURSORPOS);
+        XWindowState::unpack(m_state.cursor, x, y);
+    }
+
+    Title getTitle() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_GETTITLE);
+        return m_state.title.string();
+    }
+
+    size_t getTitle(char* buffer, size_t capacity) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_GETTITLE);
+        return m_state.title.copy(buffer, capacity);
+    }
+
+    void setTitle(char const* title) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_SETTITLE);
+        if (m_handle == 0) return;
+        applyTitle(title);
+        m_dispatcher.flush();
+    }
+
+    void setTitle(wchar_t const* title) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_SETTITLE);
+        if (m_handle == 0) return;
+        applyTitle(title);
+        m_dispatcher.flush();
+    }
+
+	PWindow getParent() const override
+    {
+        WINSTRUMENT_CALL(WCALL_GETPARENT);
+        if (m_handle == 0) return nullptr;
+        return m_dispatcher.m_tree.parent(m_node);
+    }
+
+    size_t getChildren(PWindow* children, size_t capacity) const override
+    {
+        WINSTRUMENT_CALL(WCALL_GETCHILDREN);
+        if (m_handle == 0) return 0;
+        return m_dispatcher.m_tree.children(m_node, children, capacity);
+    }
+
+    size_t getPointerHistory(PointerSample* samples, size_t capacity) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_GETPOINTERHISTORY);
+        return m_history.read(samples, capacity);
+    }
+
+    size_t takeDamage(WindowRect* rects, size_t capacity) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_TAKEDAMAGE);
+        return m_damage.take(rects, capacity);
+    }
+
+    void requestFrames(bool enabled) const override
+    {
+        WINSTRUMENT_CALL(WCALL_REQUESTFRAMES);
+        // a hibernating window starts its frames once it is shown
+        std::lock_guard<std::mutex> lock(m_hibernation);
+        if (m_pacer.request(enabled) != enabled && !(enabled && m_hibernating) && m_handle != 0)
+        {
+            m_dispatcher.frames(const_cast<XWindow*>(this), enabled);
+        }
+    }
+
+    FrameStats getFrameStats() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_GETFRAMESTATS);
+        return m_pacer.stats();
+    }
+
+    PSurface createSurface(short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATESURFACE);
+        XID xid = m_handle;
+        if (xid == 0 || width <= 0 || height <= 0) return nullptr;
+        std::shared_ptr<XSurface> surface = std::make_shared<XSurface>(m_dispatcher, xid, m_screen, width, height, m_dispatcher.m_shmCompletion != -1);
+        m_dispatcher.wake();
+        if (!surface->valid()) return nullptr;
+        if (std::shared_ptr<XSurface> previous = std::atomic_exchange(&m_surface, surface))
+        {
+            previous->release();
+        }
+        // a window closed meanwhile has not released the new surface
+        if (m_handle == 0)
+        {
+            surface->release();
+        }
+        return surface;
+    }
+
+    bool isKeyDown(unsigned char key) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_ISKEYDOWN);
+        return m_keys.test(key);
+    }
+
+    bool isLiveResizing() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_ISLIVERESIZING);
+        return m_resize.live();
+    }
+
+    size_t drainEvents(Event* events, size_t capacity) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_DRAINEVENTS);
+        return m_events.drain(events, capacity);
+    }
+
+    /**
+     * @see recordEvents
+     */
+    bool record(FILE* file) const noexcept
+    {
+        return m_events.record(file);
+    }
+
+    /**
+     * send a recorded event to the window as the X server sends its native event, so the dispatcher handles it,
+     * the text, the live resizes and the close requests are derived from the native events and left out
+     * @param event[in] the recorded event
+     * @return whether the event was sent
+     */
+    bool replay(Event const& event) const noexcept
+    {
+        XID const xid = m_handle;
+        if (xid == 0) return false;
+        Display* display = DisplayOfScreen(m_screen);
+        XEvent e{};
+        e.xany.serial = 0;
+        e.xany.send_event = True;
+        e.xany.display = display;
+        e.xany.window = xid;
+        switch (event.type)
+        {
+        case WEVENT_KEYDOWN:
+        case WEVENT_KEYUP:
+            e.xkey.type = event.type == WEVENT_KEYDOWN ? KeyPress : KeyRelease;
+            e.xkey.root = RootWindowOfScreen(m_screen);
+            e.xkey.time = CurrentTime;
+            e.xkey.x = event.x;
+            e.xkey.y = event.y;
+            e.xkey.keycode = static_cast<unsigned char>(event.code);
+            e.xkey.same_screen = True;
+            break;
+
+        case WEVENT_BUTTONDOWN:
+        case WEVENT_BUTTONUP:
+        case WEVENT_WHEEL:
+            e.xbutton.type = event.type == WEVENT_BUTTONUP ? ButtonRelease : ButtonPress;
+            e.xbutton.root = RootWindowOfScreen(m_screen);
+            e.xbutton.time = CurrentTime;
+            e.xbutton.x = event.x;
+            e.xbutton.y = event.y;
+            e.xbutton.button = event.type == WEVENT_WHEEL ? (event.code > 0 ? Button4 : Button5)
+                : event.code == WBUTTON_LEFT ? Button1
+                : event.code == WBUTTON_MIDDLE ? Button2
+                : event.code == WBUTTON_RIGHT ? Button3
+                : static_cast<unsigned int>(event.code);
+            e.xbutton.same_screen = True;
+            break;
+
+        case WEVENT_MOTION:
+            e.xmotion.type = MotionNotify;
+            e.xmotion.root = RootWindowOfScreen(m_screen);
+            e.xmotion.time = CurrentTime;
+            e.xmotion.x = event.x;
+            e.xmotion.y = event.y;
+            e.xmotion.is_hint = NotifyNormal;
+            e.xmotion.same_screen = True;
+            break;
+
+        case WEVENT_RESIZE:
+            {
+                unsigned int const position = m_state.position;
+                e.xconfigure.type = ConfigureNotify;
+                e.xconfigure.event = xid;
+                e.xconfigure.x = static_cast<short>(position & 0xffff);
+                e.xconfigure.y = static_cast<short>(position >> 16);
+                e.xconfigure.width = event.x;
+                e.xconfigure.height = event.y;
+            }
+            break;
+
+        case WEVENT_FOCUS:
+            e.xfocus.type = event.code ? FocusIn : FocusOut;
+            e.xfocus.mode = NotifyNormal;
+            e.xfocus.detail = NotifyNonlinear;
+            break;
+
+        default:
+            return false;
+        }
+        // with an empty event mask the event goes to the client that created the window, this one
+        return XSendEvent(display, xid, False, NoEventMask, &e) != 0;
+    }
+
+    void flush() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_FLUSH);
+        if (m_handle == 0) return;
+        WINSTRUMENT_COUNT(WCOUNTER_FLUSHES);
+        XFlush(DisplayOfScreen(m_screen));
+    }
+
+    void openBatch() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_OPENBATCH);
+        if (!m_orphaned) m_dispatcher.openBatch();
+    }
+
+    void endBatch() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_ENDBATCH);
+        if (!m_orphaned) m_dispatcher.endBatch();
+    }
+
+    void subscribe(PWindowListener listener) const override
+    {
+        WINSTRUMENT_CALL(WCALL_SUBSCRIBE);
+        m_listeners.add(static_cast<PWindowListener&&>(listener));
+    }
+
+    void unsubscribe(PWindowListener const& listener) const override
+    {
+        WINSTRUMENT_CALL(WCALL_UNSUBSCRIBE);
+        m_listeners.remove(listener);
+    }
+};
+
+typedef struct XRootWindow final : IWindow
+{
+    Screen* m_screen = nullptr;
+    std::unique_ptr<XDispatcher> m_dispatcher;
+
+public:
+    /**
+     * open a connection of its own to a screen
+     * @param name[in] the display name, null for the default display
+     * @param screenId[in] the screen number, -1 for the default screen
+     */
+    XRootWindow(char const* name = nullptr, int screenId = -1) noexcept
+    {
+        XInitThreads();
+        Display* display = XOpenDisplay(name);
+        if (display == nullptr) return;
+        if (screenId < 0 || screenId >= ScreenCount(display))
+        {
+            screenId = DefaultScreen(display);
+        }
+        m_screen = ScreenOfDisplay(display, screenId);
+        m_dispatcher.reset(new XDispatcher(display, event_threads, frame_rate, auto_flush, hibernate_after));
+    }
+
+    ~XRootWindow() override
+    {
+        if (m_screen == nullptr) return;
+        m_dispatcher.reset();
+		XCloseDisplay(DisplayOfScreen(m_screen));
+    }
+
+    /**
+     * called on the connected root windows only
+     * @return whether the display name and the screen number refer to the screen of the root window
+     */
+    bool is(char const* name, int screenId) const noexcept
+    {
+        Display* display = DisplayOfScreen(m_screen);
+        return std::string(XDisplayName(name)) == DisplayString(display)
+            && (screenId < 0 ? DefaultScreen(display) : screenId) == XScreenNumberOfScreen(m_screen);
+    }
+
+    PWindow create(char const* title, int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATE);
+        if (m_screen == nullptr) return nullptr;
+        return PWindow(XWindow::create(title, style, width, height, RootWindowOfScreen(m_screen), m_screen, *m_dispatcher));
+    }
+
+    PWindow create(wchar_t const* title, int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATE);
+        if (m_screen == nullptr) return nullptr;
+        return PWindow(XWindow::create(title, style, width, height, RootWindowOfScreen(m_screen), m_screen, *m_dispatcher));
+    }
+
+    PWindow create(int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATE);
+        if (m_screen == nullptr) return nullptr;
+        return PWindow(XWindow::create(static_cast<char const*>(nullptr), style, width, height, RootWindowOfScreen(m_screen), m_screen, *m_dispatcher));
+    }
+
+    std::future<PWindow> createAsync(std::string title, int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+        if (m_screen == nullptr) return unconnected();
+        return XWindow::createAsync(std::move(title), true, style, width, height, RootWindowOfScreen(m_screen), m_screen, *m_dispatcher);
+    }
+
+    std::future<PWindow> createAsync(std::wstring title, int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+        if (m_screen == nullptr) return unconnected();
+        return XWindow::createAsync(std::move(title), true, style, width, height, RootWindowOfScreen(m_screen), m_screen, *m_dispatcher);
+    }
+
+    std::future<PWindow> createAsync(int style, short width, short height) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATEASYNC);
+        if (m_screen == nullptr) return unconnected();
+        return XWindow::createAsync(std::string(), false, style, width, height, RootWindowOfScreen(m_screen), m_screen, *m_dispatcher);
+    }
+
+    std::vector<PWindow> createMany(WindowSpec const* specs, size_t count) const override
+    {
+        WINSTRUMENT_CALL(WCALL_CREATEMANY);
+        if (m_screen == nullptr) return {};
+        return XWindow::createMany(specs, count, RootWindowOfScreen(m_screen), m_screen, *m_dispatcher);
+    }
+
+	void show() const noexcept override {}
+
+    void minimize() const noexcept override {}
+
+    void hide() const noexcept override {}
+
+    void close() const noexcept override {}
+
+	bool isClosed() const noexcept override { return false; }
+
+	bool isVisible() const noexcept override { return false; }
+
+	bool isHidden() const noexcept override { return false; }
+
+    bool isActive() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_ISACTIVE);
+        if (m_screen == nullptr) return false;
+        XID focus = 0;
+        int revert_to;
+        WINSTRUMENT_COUNT(WCOUNTER_ROUNDTRIPS);
+        XGetInputFocus(DisplayOfScreen(m_screen), &focus, &revert_to);
+        m_dispatcher->wake();
+        return focus == RootWindowOfScreen(m_screen);
+    }
+
+	void getClientSize(short& width, short& height) const noexcept override
+	{
+		WINSTRUMENT_CALL(WCALL_GETCLIENTSIZE);
+		if (m_screen == nullptr)
+		{
+			width = height = 0;
+			return;
+		}
+		width = m_screen->width;
+		height = m_screen->height;
+	}
+
+    void getClientCursorPos(short& x, short& y) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_GETCLIENTCURSORPOS);
+        if (m_screen == nullptr)
+        {
+            x = y = 0;
+            return;
+        }
+        XID root, child;
+        int root_x, root_y, win_x, win_y;
+        unsigned int mask;
+        WINSTRUMENT_COUNT(WCOUNTER_ROUNDTRIPS);
+        XQueryPointer(DisplayOfScreen(m_screen), RootWindowOfScreen(m_screen), &root, &child, &root_x, &root_y, &win_x, &win_y, &mask);
+        m_dispatcher->wake();
+		x = root_x;
+		y = root_y;
+    }
+
+    Title getTitle() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_GETTITLE);
         return {};
     }
 
+    size_t getTitle(char* buffer, size_t capacity) const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_GETTITLE);
+        if (capacity) *buffer = '\0';
+        return 0;
+    }
+
     void setTitle(char const* title) const noexcept override {}
 
     void setTitle(wchar_t const* title) const noexcept override {}
 
-	PWindow getParent() const override { return root_window; }
+	PWindow getParent() const override
+	{
+		if (m_screen == nullptr) return nullptr;
+		return PWindow(m_dispatcher->m_tree.root.window.lock());
+	}
+
+    size_t getChildren(PWindow* children, size_t capacity) const override
+    {
+        WINSTRUMENT_CALL(WCALL_GETCHILDREN);
+        if (m_screen == nullptr) return 0;
+        return m_dispatcher->m_tree.children(m_dispatcher->m_tree.root, children, capacity);
+    }
+
+    size_t getPointerHistory(PointerSample* samples, size_t capacity) const noexcept override { return 0; }
+
+    size_t takeDamage(WindowRect* rects, size_t capacity) const noexcept override { return 0; }
+
+    void requestFrames(bool enabled) const override {}
+
+    FrameStats getFrameStats() const noexcept override { return FrameStats{}; }
+
+    PSurface createSurface(short width, short height) const override { return nullptr; }
+
+    bool isKeyDown(unsigned char key) const noexcept override { return false; }
+
+    bool isLiveResizing() const noexcept override { return false; }
+
+    size_t drainEvents(Event* events, size_t capacity) const noexcept override { return 0; }
+
+    void flush() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_FLUSH);
+        if (m_screen == nullptr) return;
+        WINSTRUMENT_COUNT(WCOUNTER_FLUSHES);
+        XFlush(DisplayOfScreen(m_screen));
+    }
+
+    void openBatch() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_OPENBATCH);
+        if (m_screen) m_dispatcher->openBatch();
+    }
+
+    void endBatch() const noexcept override
+    {
+        WINSTRUMENT_CALL(WCALL_ENDBATCH);
+        if (m_screen) m_dispatcher->endBatch();
+    }
+
+    void subscribe(PWindowListener listener) const override {}
+
+    void unsubscribe(PWindowListener const& listener) const override {}
+
+private:
+    /**
+     * @return the future of a window never created, a root window failing to open its display creates none
+     */
+    static std::future<PWindow> unconnected()
+    {
+        std::promise<PWindow> closed;
+        closed.set_value(nullptr);
+        return closed.get_future();
+    }
 } XRootWindow__;
 
+// the root windows of the displays and screens opened by getRootWindow, the default one included
+static std::mutex root_windows_mutex;
+static std::vector<std::shared_ptr<XRootWindow__>> root_windows;
+
+XDispatcher::~XDispatcher() noexcept
+{
+    m_running = false;
+    wake();
+    if (m_thread.joinable()) m_thread.join();
+    m_workers.clear();
+    if (m_wakeup[0] != -1) ::close(m_wakeup[0]);
+    if (m_wakeup[1] != -1) ::close(m_wakeup[1]);
+
+    std::unordered_set<XWindow*> windows;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        windows.swap(m_windows);
+    }
+    for (XWindow* window : windows)
+    {
+        window->m_orphaned = true;
+        window->detach(false);
+    }
+    if (m_im) XCloseIM(m_im);
+}
+
+WindowTree::Node* XDispatcher::node(XID xid) const noexcept
+{
+    XWindow* window = nullptr;
+    if (XFindContext(m_display, xid, xUniqueContext(), reinterpret_cast<XPointer*>(&window)) == 0 && window)
+    {
+        return &window->m_node;
+    }
+    return nullptr;
+}
+
+void XDispatcher::route(Display* display, XEvent& e, bool superseded) noexcept
+{
+    XWindow* window = nullptr;
+    if (XFindContext(display, e.xany.window, xUniqueContext(), reinterpret_cast<XPointer*>(&window)) == 0 && window)
+    {
+        window->dispatch(e, superseded);
+    }
+}
+
+void XEventWorker::loop(Display* display) noexcept
+{
+    dispatching = display;
+    Trace::name("X event worker");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this]() { return !m_running || !m_events.empty(); });
+        if (m_events.empty()) break;
+        XEvent e = m_events.front();
+        m_events.pop_front();
+        // the events queued while a listener was busy collapse too
+        bool const superseded = !m_events.empty() && XDispatcher::supersedes(m_events.front(), e);
+        lock.unlock();
+        XDispatcher::route(display, e, superseded);
+        // the requests of the listeners go out once the events queued meanwhile are dispatched
+        if (m_autoFlush)
+        {
+            lock.lock();
+            bool const idle = m_events.empty();
+            lock.unlock();
+            if (idle)
+            {
+                WINSTRUMENT_COUNT(WCOUNTER_FLUSHES);
+                XFlush(display);
+            }
+        }
+        lock.lock();
+    }
+}
+
+void XDispatcher::message(XWindow const* window, Atom type)
+{
+    XEvent e{};
+    e.xclient.type = ClientMessage;
+    e.xclient.send_event = True;
+    e.xclient.display = m_display;
+    e.xclient.window = window->m_handle;
+    e.xclient.message_type = type;
+    e.xclient.format = 32;
+    m_messages.push_back(e);
+}
+
+bool XDispatcher::tick(std::chrono::steady_clock::time_point& deadline) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_framed.empty() && m_resizing.empty() && m_idle.empty()) return false;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        deadline = std::chrono::steady_clock::time_point::max();
+        if (!m_framed.empty())
+        {
+            if (now >= m_nextFrame)
+            {
+                // a late tick keeps the cadence unless a whole period was missed
+                m_nextFrame = m_nextFrame + m_frameInterval > now ? m_nextFrame + m_frameInterval : now + m_frameInterval;
+                for (XWindow* window : m_framed)
+                {
+                    if (window->m_pacer.claim()) message(window, m_atoms._WINDOWINPUT_FRAME);
+                }
+            }
+            deadline = m_nextFrame;
+        }
+        for (std::unordered_set<XWindow*>::iterator it = m_resizing.begin(); it != m_resizing.end();)
+        {
+            // the window checks the pause again, a size may have changed since
+            std::chrono::steady_clock::time_point end(std::chrono::microseconds((*it)->m_resizeTime.load()) + m_resizePause);
+            if (now < end)
+            {
+                if (end < deadline) deadline = end;
+                ++it;
+                continue;
+            }
+            message(*it, m_atoms._WINDOWINPUT_RESIZE);
+            it = m_resizing.erase(it);
+        }
+        for (std::unordered_set<XWindow*>::iterator it = m_idle.begin(); it != m_idle.end();)
+        {
+            // the window checks it is still hidden, it may have been shown since
+            std::chrono::steady_clock::time_point end(std::chrono::microseconds((*it)->m_hiddenTime.load()) + m_hibernateAfter);
+            if (now < end)
+            {
+                if (end < deadline) deadline = end;
+                ++it;
+                continue;
+            }
+            message(*it, m_atoms._WINDOWINPUT_HIBERNATE);
+            it = m_idle.erase(it);
+        }
+    }
+    for (XEvent& e : m_messages)
+    {
+        post(e);
+    }
+    m_messages.clear();
+    return deadline != std::chrono::steady_clock::time_point::max();
+}
+
+void XDispatcher::loop() noexcept
+{
+    pollfd fds[2] {
+        { ConnectionNumber(m_display), POLLIN, 0 },
+        { m_wakeup[0], POLLIN, 0 },
+    };
+    dispatching = m_display;
+    Trace::name("X dispatcher");
+    XEvent e;
+    while (m_running)
+    {
+        // XPending sends the requests queued by the dispatch of the previous events
+        while (XPending(m_display))
+        {
+            XNextEvent(m_display, &e);
+            WTRACE_INSTANT("pickup", e.type);
+            WINSTRUMENT_NATIVE(e.type);
+            // the input method consumes the events composing a character
+            if (XFilterEvent(&e, None)) continue;
+            WINSTRUMENT_DEPTH(WQUEUE_DISPATCH, XQLength(m_display) + 1);
+            post(e);
+        }
+        timespec timeout{};
+        timespec* p_timeout = nullptr;
+        std::chrono::steady_clock::time_point deadline;
+        bool const due = tick(deadline);
+        // the frames dispatched meanwhile have no XPending after them before the poll
+        if (m_autoFlush)
+        {
+            WINSTRUMENT_COUNT(WCOUNTER_FLUSHES);
+            XFlush(m_display);
+        }
+        if (due)
+        {
+            long long wait = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (wait < 0) wait = 0;
+            timeout.tv_sec = wait / 1000000000;
+            timeout.tv_nsec = wait % 1000000000;
+            p_timeout = &timeout;
+        }
+        if (ppoll(fds, fds[1].fd == -1 ? 1 : 2, p_timeout, nullptr) < 0 && errno != EINTR) break;
+        WINSTRUMENT_COUNT(WCOUNTER_WAKEUPS);
+        if (fds[1].revents & POLLIN)
+        {
+            char buffer[64];
+            while (read(m_wakeup[0], buffer, sizeof buffer) > 0) {}
+            run();
+        }
+    }
+}
+
+/**
+ * @return the root window of a screen, opened by the first call asking for it,
+ * without a connection if the display cannot be opened
+ */
+static std::shared_ptr<XRootWindow__> openRootWindow(char const* display, int screen)
+{
+    std::lock_guard<std::mutex> lock(root_windows_mutex);
+    for (std::shared_ptr<XRootWindow__> const& root : root_windows)
+    {
+        if (root->is(display, screen)) return root;
+    }
+    std::shared_ptr<XRootWindow__> root = std::make_shared<XRootWindow__>(display, screen);
+    if (root->m_screen == nullptr) return root;
+    root->m_dispatcher->m_tree.root.window = root;
+    root_windows.push_back(root);
+    return root;
+}
+
 EXTERN_C Window getRootWindow()
 {
     if (root_window == nullptr)
     {
-        root_window = std::make_shared<XRootWindow__>();
+        // the default screen is shared with getRootWindow(nullptr, -1)
+        root_window = openRootWindow(nullptr, -1);
     }
     return *root_window;
 }
+
+PWindow getRootWindow(char const* display, int screen)
+{
+    std::shared_ptr<XRootWindow__> root = openRootWindow(display, screen);
+    return root->m_screen ? root : nullptr;
+}
+
+EXTERN_C void setEventThreads(unsigned int threads)
+{
+    event_threads = threads;
+}
+
+EXTERN_C void setFrameRate(unsigned int hz)
+{
+    frame_rate = hz;
+}
+
+EXTERN_C void setAutoFlush(bool enabled)
+{
+    auto_flush = enabled;
+}
+
+EXTERN_C void setHibernation(unsigned int ms)
+{
+    hibernate_after = ms;
+}
+
+void setWindowMemory(std::pmr::memory_resource* resource)
+{
+    windowMemoryResource() = resource ? resource : defaultWindowMemory();
+}
+
+bool getInstrumentation(InstrumentationSnapshot& snapshot) noexcept
+{
+    return Instrumentation::take(snapshot);
+}
+
+void dumpInstrumentation(FILE* file, bool json) noexcept
+{
+    Instrumentation::dump(file, json);
+}
+
+void setInstrumentationDump(FILE* file, unsigned int interval, bool json)
+{
+    Instrumentation::schedule(file, interval, json);
+}
+
+void setTracing(bool enabled) noexcept
+{
+    Trace::get().enable(enabled);
+}
+
+bool exportTrace(FILE* file)
+{
+    return Trace::get().write(file);
+}
+
+bool recordEvents(Window window, FILE* file)
+{
+    XWindow const* p_window = dynamic_cast<XWindow const*>(&window);
+    return p_window ? p_window->record(file) : false;
+}
+
+size_t replayEvents(Window window, FILE* file, double speed)
+{
+    XWindow const* p_window = dynamic_cast<XWindow const*>(&window);
+    if (p_window == nullptr) return 0;
+    size_t const count = replayEventFile(file, speed, [p_window, speed](Event const& event) {
+        if (p_window->replay(event) && speed > 0)
+        {
+            // paced events reach the server at their time, the unpaced ones go out as the request buffer fills
+            p_window->flush();
+        }
+    });
+    p_window->flush();
+    return count;
+}
+
+EXTERN_C void releaseRootWindow()
+{
+    root_window = nullptr;
+    std::vector<std::shared_ptr<XRootWindow__>> roots;
+    {
+        std::lock_guard<std::mutex> lock(root_windows_mutex);
+        roots.swap(root_windows);
+    }
+}